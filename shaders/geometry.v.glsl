@@ -3,10 +3,17 @@
 layout (location = 0) in vec3 position;
 layout (location = 1) in vec2 texcoords;
 layout (location = 2) in vec3 normals;
+layout (location = 3) in mat4 world;
 
-uniform mat4 world;
-uniform mat4 view;
-uniform mat4 projection;
+layout (std140) uniform Frame {
+	mat4 view;
+	mat4 projection;
+	mat4 inverse_view;
+	mat4 inverse_projection;
+	vec4 camera_position;
+	vec2 resolution;
+	float time;
+};
 
 out vec3 vNormal;
 out vec3 vFragPos;
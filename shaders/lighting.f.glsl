@@ -8,7 +8,15 @@ uniform sampler2D gNormal;     // World space normals
 uniform sampler2D gAlbedoSpec; // Albedo in rgb spec in a
 uniform sampler2D ssaoInput;
 
-uniform vec3 viewPos; // Viewport position
+layout (std140) uniform Frame {
+	mat4 view;
+	mat4 projection;
+	mat4 inverse_view;
+	mat4 inverse_projection;
+	vec4 camera_position;
+	vec2 resolution;
+	float time;
+};
 
 const vec3 sundir = vec3(1, 1, 0); // Sun Direction
 
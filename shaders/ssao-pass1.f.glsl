@@ -10,8 +10,16 @@ uniform sampler2D gDepth;
 uniform sampler2D texNoise;
 
 uniform vec3 samples[64];
-uniform mat4 view;
-uniform mat4 projection;
+
+layout (std140) uniform Frame {
+	mat4 view;
+	mat4 projection;
+	mat4 inverse_view;
+	mat4 inverse_projection;
+	vec4 camera_position;
+	vec2 resolution;
+	float time;
+};
 
 const int kernelSize = 32;
 const float radius = 2.0;
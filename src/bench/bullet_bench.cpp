@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "core/bullet.hpp"
+
+// Throughput of the bullet movement step for growing bullet counts, vector kernel
+// against the scalar fallback.
+
+// The world's store is capped at a match's worth of bullets, the benchmark keeps its
+// own columns so it can go far past that
+struct bench_bullets {
+	std::vector<float> loc_x, loc_y;
+	std::vector<float> prev_x, prev_y;
+	std::vector<float> vel_x, vel_y;
+	std::vector<float> lifespan;
+	std::vector<int32_t> cell;
+
+	std::size_t size() const {
+		return loc_x.size();
+	}
+	bullet::bullet_columns columns() {
+		return bullet::bullet_columns{loc_x.data(), loc_y.data(), prev_x.data(), prev_y.data(),
+		                              vel_x.data(), vel_y.data(), lifespan.data(), cell.data(),
+		                              size()};
+	}
+};
+
+static bench_bullets make_bullets(std::size_t count, std::size_t size, std::mt19937& prng) {
+	std::uniform_real_distribution<float> loc_urd(0.0f, static_cast<float>(size - 1));
+	std::uniform_real_distribution<float> vel_urd(-15.0f, 15.0f);
+
+	bench_bullets bullets;
+	for (std::size_t i = 0; i < count; ++i) {
+		bullets.loc_x.push_back(loc_urd(prng));
+		bullets.loc_y.push_back(loc_urd(prng));
+		bullets.vel_x.push_back(vel_urd(prng));
+		bullets.vel_y.push_back(vel_urd(prng));
+		// Long enough that nothing expires during the run
+		bullets.lifespan.push_back(1e9f);
+	}
+	bullets.prev_x = bullets.loc_x;
+	bullets.prev_y = bullets.loc_y;
+	bullets.cell.assign(count, bullet::cell_outside);
+	return bullets;
+}
+
+template <class F>
+static double time_kernel(bench_bullets bullets, std::size_t size, F&& kernel) {
+	// Aim for roughly the same amount of work per measurement
+	const std::size_t iterations = std::max<std::size_t>(16, (1u << 24) / bullets.size());
+	constexpr float time_step = 1.0f / 120.0f;
+
+	auto start = std::chrono::steady_clock::now();
+	for (std::size_t i = 0; i < iterations; ++i) {
+		// Flip the direction every pass so bullets stay on the grid
+		kernel(bullets.columns(), (i & 1) ? -time_step : time_step, size, size);
+	}
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	volatile int32_t sink = bullets.cell[bullets.size() / 2];
+	(void) sink;
+
+	return static_cast<double>(bullets.size() * iterations) / elapsed.count();
+}
+
+int main(int argc, char** argv) {
+	std::size_t max_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : (1u << 20);
+	constexpr std::size_t size = 1024;
+
+	std::mt19937 prng(5489u);
+
+	std::cout << std::setw(10) << "bullets" << std::setw(16) << "vector Mb/s" << std::setw(16)
+	          << "scalar Mb/s" << std::setw(10) << "speedup" << '\n';
+
+	for (std::size_t count = 16; count <= max_count; count *= 4) {
+		auto bullets = make_bullets(count, size, prng);
+
+		double vector_rate = time_kernel(bullets, size, bullet::integrate);
+		double scalar_rate = time_kernel(bullets, size, bullet::integrate_scalar);
+
+		std::cout << std::setw(10) << count << std::setw(16) << std::fixed << std::setprecision(1)
+		          << vector_rate / 1e6 << std::setw(16) << scalar_rate / 1e6 << std::setw(10)
+		          << std::setprecision(2) << vector_rate / scalar_rate << '\n';
+	}
+
+	return 0;
+}
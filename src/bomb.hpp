@@ -1,20 +1,10 @@
 #pragma once
 
-#include <cstddef>
-#include <vector>
+#include "core/game.hpp"
+#include "core/bomb.hpp"
+#include <GL/glew.h>
 
 namespace bomb {
-	struct bomb_data {
-		std::size_t x, y;
-		float time;
-		bool live = true;
-		bool active = true;
-	};
-
-	extern std::vector<bomb_data> bombs;
-
-	void initialize();
-	void add_bomb(std::size_t x, std::size_t y, float time);
-	void update_bombs(float time_elapsed);
-	void render(GLuint world_matrix_uniform);
+	void initialize_render();
+	void render(const game::World& world);
 }
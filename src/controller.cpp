@@ -16,7 +16,7 @@ void control::initialize() {
 			SDL_Joystick* joy = SDL_GameControllerGetJoystick(gpad);
 			int instance_id = SDL_JoystickInstanceID(joy);
 
-			if (manager.joy_count < 4) {
+			if (manager.joy_count < max_players) {
 				auto&& player = manager.players[manager.joy_count];
 				player.id = gpad;
 				player.joyid = joy;
@@ -165,9 +165,9 @@ void control::controller_button_press(const SDL_ControllerButtonEvent& event) {
 control::movement_report_type control::movement_report() {
 	constexpr auto joystick_deadzone = 3000;
 
-	std::array<control::controller_report, 4> report;
+	movement_report_type report;
 
-	for (std::size_t i = 0; i < 4; ++i) {
+	for (std::size_t i = 0; i < report.size(); ++i) {
 		auto&& player = manager.players[i];
 		auto&& report_section = report[i];
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "core/controller_report.hpp"
 #include <SDL2/SDL.h>
 #include <array>
 #include <cinttypes>
@@ -22,23 +23,11 @@ namespace control {
 		std::array<bool, 15> keys = {{false}};
 	};
 
-	struct controller_report {
-		enum class direction { none, up, down, left, right };
-		direction left_stick_dir;
-		direction right_stick_dir;
-		std::array<bool, 15> keys;
-		bool active;
-		bool ltrigger;
-		bool rtrigger;
-	};
-
 	extern struct controller_manager {
 		std::size_t joy_count = 0;
-		controller players[4];
+		controller players[max_players];
 	} manager;
 
-	using movement_report_type = std::array<controller_report, 4>;
-
 	void initialize();
 	void add_controller(const SDL_ControllerDeviceEvent& event);
 	void remove_controller(const SDL_ControllerDeviceEvent& event);
@@ -0,0 +1,78 @@
+#include "bitstream.hpp"
+
+#include <cstring>
+
+void Bit_Writer::write(uint32_t value, unsigned bits) {
+	if (bits < 32) {
+		value &= (uint32_t(1) << bits) - 1;
+	}
+	scratch |= uint64_t(value) << scratch_bits;
+	scratch_bits += bits;
+	while (scratch_bits >= 8) {
+		bytes.push_back(static_cast<uint8_t>(scratch));
+		scratch >>= 8;
+		scratch_bits -= 8;
+	}
+}
+
+void Bit_Writer::align() {
+	if (scratch_bits > 0) {
+		bytes.push_back(static_cast<uint8_t>(scratch));
+		scratch = 0;
+		scratch_bits = 0;
+	}
+}
+
+void Bit_Writer::write_bytes(const void* data, std::size_t size) {
+	align();
+	auto first = static_cast<const uint8_t*>(data);
+	bytes.insert(bytes.end(), first, first + size);
+}
+
+void Bit_Writer::clear() {
+	bytes.clear();
+	scratch = 0;
+	scratch_bits = 0;
+}
+
+const std::vector<uint8_t>& Bit_Writer::finish() {
+	align();
+	return bytes;
+}
+
+uint32_t Bit_Reader::read(unsigned bits) {
+	if (position + bits > size * 8) {
+		overflow = true;
+		position = size * 8;
+		return 0;
+	}
+
+	uint32_t value = 0;
+	unsigned done = 0;
+	while (done < bits) {
+		auto byte = data[position / 8];
+		auto offset = static_cast<unsigned>(position % 8);
+		auto take = 8 - offset < bits - done ? 8 - offset : bits - done;
+		auto piece = static_cast<uint32_t>(byte >> offset) & ((1u << take) - 1);
+		value |= piece << done;
+		done += take;
+		position += take;
+	}
+	return value;
+}
+
+void Bit_Reader::align() {
+	position = (position + 7) / 8 * 8;
+}
+
+void Bit_Reader::read_bytes(void* out, std::size_t count) {
+	align();
+	if (position / 8 + count > size) {
+		overflow = true;
+		position = size * 8;
+		std::memset(out, 0, count);
+		return;
+	}
+	std::memcpy(out, data + position / 8, count);
+	position += count * 8;
+}
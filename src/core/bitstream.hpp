@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <vector>
+
+// Packs values of any width up to 32 bits into bytes, lowest bit first. Whole
+// blocks of bytes can be written after align() for data that isn't worth packing.
+class Bit_Writer {
+  public:
+	void write(uint32_t value, unsigned bits);
+	void write_bool(bool value) {
+		write(value ? 1 : 0, 1);
+	}
+	void align();
+	void write_bytes(const void* data, std::size_t size);
+	void clear();
+
+	// Bits written so far
+	std::size_t bit_count() const {
+		return bytes.size() * 8 + scratch_bits;
+	}
+	// Aligns first, so the last byte is complete
+	const std::vector<uint8_t>& finish();
+
+  private:
+	std::vector<uint8_t> bytes;
+	uint64_t scratch = 0;
+	unsigned scratch_bits = 0;
+};
+
+// Reads what Bit_Writer wrote. Reading past the end returns zeros and sets the
+// overflow flag instead of failing on every call.
+class Bit_Reader {
+  public:
+	Bit_Reader(const uint8_t* bytes, std::size_t byte_count) : data(bytes), size(byte_count){};
+
+	uint32_t read(unsigned bits);
+	bool read_bool() {
+		return read(1) != 0;
+	}
+	void align();
+	void read_bytes(void* out, std::size_t count);
+
+	bool overflowed() const {
+		return overflow;
+	}
+	// Marks the stream as bad, for readers that find data that doesn't make sense
+	void fail() {
+		overflow = true;
+	}
+	std::size_t bytes_left() const {
+		return size - byte_position();
+	}
+	std::size_t byte_position() const {
+		return (position + 7) / 8;
+	}
+
+  private:
+	const uint8_t* data;
+	std::size_t size;
+	std::size_t position = 0;
+	bool overflow = false;
+};
@@ -0,0 +1,189 @@
+#include "bomb.hpp"
+#include "game.hpp"
+#include "gamegrid.hpp"
+#include "player.hpp"
+#include "spatial_index.hpp"
+
+#include <algorithm>
+#include <array>
+#include <functional>
+
+Entity bomb::add_bomb(game::World& world, std::size_t owner, std::size_t x, std::size_t y,
+                      float fuse) {
+	auto&& bombs = world.bombs;
+	bomb_data bd;
+	bd.x = x;
+	bd.y = y;
+	bd.owner = owner;
+	bd.id = world.next_id;
+	// A full store refuses the bomb and counts it
+	auto handle = bombs.push_back(bd);
+	if (handle.slot == no_entity.slot) {
+		return handle;
+	}
+	world.next_id += 1;
+	bombs.timer[bombs.size() - 1] = world.timers.schedule(
+	    game::ticks_from_now(world, fuse),
+	    timer::event{static_cast<uint32_t>(game::timer_kind::bomb_fuse), handle.slot});
+	return handle;
+}
+
+// Directions in the order of bomb_data::reach
+static constexpr std::array<long, 4> step_x = {{-1, 1, 0, 0}};
+static constexpr std::array<long, 4> step_y = {{0, 0, -1, 1}};
+
+std::array<uint8_t, 4> bomb::blast_reach(const gamegrid::GameGrid& grid, std::size_t x,
+                                         std::size_t y) {
+	std::array<uint8_t, 4> reach = {{0, 0, 0, 0}};
+	for (std::size_t d = 0; d < 4; ++d) {
+		for (long k = 1; k <= bomb::blast_range; ++k) {
+			auto cx = static_cast<long>(x) + step_x[d] * k;
+			auto cy = static_cast<long>(y) + step_y[d] * k;
+			if (cx < 0 || cy < 0 || cx >= static_cast<long>(grid.width) ||
+			    cy >= static_cast<long>(grid.height) ||
+			    gamegrid::test(grid, gamegrid::StateType::trap, static_cast<std::size_t>(cx),
+			                   static_cast<std::size_t>(cy))) {
+				break;
+			}
+			reach[d] = static_cast<uint8_t>(k);
+		}
+	}
+	return reach;
+}
+
+void bomb::update_bombs(game::World& world) {
+	auto&& grid = world.grid;
+	auto&& bombs = world.bombs;
+	auto&& blast = world.blast;
+
+	// Bombs placed this tick can be set off by a chain reaction too
+	spatial::index_bombs(world);
+
+	// Only bombs whose timers fired this tick are looked at
+	blast.queue.clear();
+	blast.finished.clear();
+	for (auto&& ev : world.fired) {
+		auto target = bombs.entities.find_slot(ev.target);
+		switch (static_cast<game::timer_kind>(ev.kind)) {
+			case game::timer_kind::bomb_fuse:
+				bombs.timer[target] = timer::no_timer;
+				bombs.live[target] = false;
+				blast.queue.push_back(target);
+				break;
+			case game::timer_kind::bomb_blast:
+				bombs.timer[target] = timer::no_timer;
+				blast.finished.push_back(target);
+				break;
+			default:
+				break;
+		}
+	}
+
+	// Each bomb goes off once. A blast that reaches another bomb adds it to the
+	// queue, so the whole chain resolves this tick. Every detonation touches at most
+	// 4 * blast_range + 1 cells, however many bombs or cells there are.
+	std::array<bool, control::max_players> hit = {};
+	std::array<std::size_t, control::max_players> killer = {};
+	auto&& index = world.index;
+	for (std::size_t head = 0; head < blast.queue.size(); ++head) {
+		auto bomb_index = blast.queue[head];
+		auto bomb_x = bombs.x[bomb_index];
+		auto bomb_y = bombs.y[bomb_index];
+		auto owner = bombs.owner[bomb_index];
+		auto&& reach = bombs.reach[bomb_index];
+		auto origin = bomb_y * grid.width + bomb_x;
+		reach = blast_reach(grid, bomb_x, bomb_y);
+		bombs.timer[bomb_index] = world.timers.schedule(
+		    game::ticks_from_now(world, blast_duration),
+		    timer::event{static_cast<uint32_t>(game::timer_kind::bomb_blast),
+		                       bombs.entities.handle(bomb_index).slot});
+
+		auto visit = [&](int32_t cell) {
+			for (auto it = index.players.begin(cell); it != index.players.end(cell); ++it) {
+				if (!hit[it->id]) {
+					hit[it->id] = true;
+					killer[it->id] = owner;
+				}
+			}
+			for (auto it = index.bombs.begin(cell); it != index.bombs.end(cell); ++it) {
+				if (bombs.live[it->id]) {
+					bombs.live[it->id] = false;
+					world.timers.cancel(bombs.timer[it->id]);
+					bombs.timer[it->id] = timer::no_timer;
+					blast.queue.push_back(it->id);
+				}
+			}
+		};
+
+		visit(static_cast<int32_t>(origin));
+		for (std::size_t d = 0; d < 4; ++d) {
+			for (long k = 1; k <= reach[d]; ++k) {
+				auto x = static_cast<long>(bomb_x) + step_x[d] * k;
+				auto y = static_cast<long>(bomb_y) + step_y[d] * k;
+				visit(static_cast<int32_t>(y * static_cast<long>(grid.width) + x));
+			}
+		}
+	}
+
+	// Kill after the blasts, killing respawns the player and changes the index
+	for (std::size_t pi = 0; pi < hit.size(); ++pi) {
+		if (hit[pi]) {
+			players::kill(world, pi, killer[pi]);
+		}
+	}
+
+	// Swap the last bomb into each finished one. Going from the highest index down
+	// means the bomb moved in is never one that is also finished.
+	std::sort(blast.finished.begin(), blast.finished.end(), std::greater<std::size_t>());
+	for (auto done : blast.finished) {
+		bombs.remove(done);
+	}
+	spatial::index_bombs(world);
+}
+
+Entity bomb::bomb_store::push_back(const bomb_data& bd) {
+	auto i = entities.size();
+	auto handle = entities.create();
+	if (handle.slot == no_entity.slot) {
+		return handle;
+	}
+
+	x[i] = bd.x;
+	y[i] = bd.y;
+	timer[i] = bd.timer;
+	owner[i] = bd.owner;
+	id[i] = bd.id;
+	live[i] = bd.live;
+	reach[i] = bd.reach;
+	return handle;
+}
+
+bomb::bomb_data bomb::bomb_store::get(std::size_t index) const {
+	bomb_data bd;
+	bd.x = x[index];
+	bd.y = y[index];
+	bd.timer = timer[index];
+	bd.owner = owner[index];
+	bd.id = id[index];
+	bd.live = live[index];
+	bd.reach = reach[index];
+	return bd;
+}
+
+void bomb::bomb_store::move(std::size_t to, std::size_t from) {
+	x[to] = x[from];
+	y[to] = y[from];
+	timer[to] = timer[from];
+	owner[to] = owner[from];
+	id[to] = id[from];
+	live[to] = live[from];
+	reach[to] = reach[from];
+}
+
+void bomb::bomb_store::clear() {
+	entities.clear();
+}
+
+void bomb::bomb_store::remove(std::size_t index) {
+	entities.remove(index, [&](std::size_t to, std::size_t from) { move(to, from); });
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "entity.hpp"
+#include "fixed_vector.hpp"
+#include "timer_wheel.hpp"
+
+#include <array>
+#include <cinttypes>
+#include <cstddef>
+
+#ifndef BOMBERMAN_MAX_BOMBS
+#define BOMBERMAN_MAX_BOMBS 64
+#endif
+
+namespace game {
+	struct World;
+}
+
+namespace gamegrid {
+	struct GameGrid;
+}
+
+namespace bomb {
+	struct bomb_data {
+		std::size_t x, y;
+		// Fuse while live, then the end of the explosion
+		timer::timer_id timer = timer::no_timer;
+		std::size_t owner;
+		// Serial number from World::next_id
+		uint32_t id;
+		bool live = true;
+		// Cells the blast covered in each direction (left, right, up, down), set when
+		// the bomb goes off
+		std::array<uint8_t, 4> reach = {{0, 0, 0, 0}};
+	};
+
+	// Cells a blast travels from the bomb in each direction
+	constexpr uint8_t blast_range = 3;
+
+	// Bombs on the grid at once, set with the BOMBERMAN_MAX_BOMBS CMake option. Each
+	// one holds a single timer at a time.
+	constexpr std::size_t max_bombs = BOMBERMAN_MAX_BOMBS;
+
+	// Bomb archetype, index i in every column is the same bomb. Timers point at a
+	// bomb's slot in entities, so they stay valid when bombs are moved around.
+	struct bomb_store {
+		template <class T>
+		using column = std::array<T, max_bombs>;
+
+		column<std::size_t> x, y;
+		column<timer::timer_id> timer;
+		column<std::size_t> owner;
+		column<uint32_t> id;
+		column<bool> live;
+		column<std::array<uint8_t, 4>> reach;
+		Entity_Table<max_bombs> entities;
+
+		std::size_t size() const {
+			return entities.size();
+		}
+		bool full() const {
+			return entities.full();
+		}
+
+		// no_entity, and nothing added, when the store is full
+		Entity push_back(const bomb_data& bd);
+		bomb_data get(std::size_t index) const;
+		void move(std::size_t to, std::size_t from);
+		void clear();
+		// Moves the last bomb into index
+		void remove(std::size_t index);
+	};
+
+	// Scratch for one tick's detonations, kept in the world so nothing allocates
+	struct blast_state {
+		// Bombs waiting to go off this tick, in the order they were triggered
+		Fixed_Vector<std::size_t, max_bombs> queue;
+		// Bombs whose explosion ended this tick
+		Fixed_Vector<std::size_t, max_bombs> finished;
+	};
+
+	// Seconds an explosion stays around after the bomb goes off
+	constexpr float blast_duration = 0.15f;
+
+	// How far a blast from (x, y) travels in each direction, in the order of
+	// bomb_data::reach, before a trap or the edge of the grid stops it
+	std::array<uint8_t, 4> blast_reach(const gamegrid::GameGrid& grid, std::size_t x,
+	                                   std::size_t y);
+
+	// Does nothing but count the failure and returns no_entity when the bomb store is full
+	Entity add_bomb(game::World& world, std::size_t owner, std::size_t x, std::size_t y,
+	                float fuse);
+	void update_bombs(game::World& world);
+}
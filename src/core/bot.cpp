@@ -0,0 +1,602 @@
+#include "bot.hpp"
+#include "bomb.hpp"
+#include "game.hpp"
+#include "gamegrid.hpp"
+#include "player.hpp"
+
+#include <algorithm>
+
+constexpr uint16_t Bot_Fields::unreachable;
+constexpr uint16_t Bot_Fields::hunt_radius;
+
+using direction = control::controller_report::direction;
+
+// Moves in the order neighbours are visited: left, right, up, down
+static constexpr std::array<direction, 4> moves = {
+    {direction::left, direction::right, direction::up, direction::down}};
+static constexpr std::array<long, 4> move_x = {{-1, 1, 0, 0}};
+static constexpr std::array<long, 4> move_y = {{0, 0, -1, 1}};
+
+// Cells a bot looks down for a player to shoot at
+static constexpr long shot_range = 12;
+
+static constexpr uint32_t no_cell = 0xFFFFFFFF;
+
+// Low byte of a queued hunt entry
+static constexpr uint32_t player_bits = 0x7F;
+static constexpr uint32_t offer = 0x80;
+static_assert(control::max_players <= player_bits + 1, "Hunt entries keep the slot in 7 bits");
+
+template <class F>
+void Bot_Fields::for_each_neighbour(std::size_t cell, F&& f) const {
+	auto bits = exits[cell];
+	if (bits & 1) {
+		f(cell - 1);
+	}
+	if (bits & 2) {
+		f(cell + 1);
+	}
+	if (bits & 4) {
+		f(cell - width);
+	}
+	if (bits & 8) {
+		f(cell + width);
+	}
+}
+
+uint16_t Bot_Fields::hunt_distance(std::size_t x, std::size_t y, std::size_t self) const {
+	auto&& hc = hunt[y * width + x];
+	for (std::size_t k = 0; k < hc.count; ++k) {
+		if (hc.player[k] != self) {
+			return hc.distance[k];
+		}
+	}
+	return unreachable;
+}
+
+void Bot_Fields::update(const game::World& world) {
+	auto&& grid = world.grid;
+	if (!built || grid.width != width || grid.height != height || grid.revision != revision) {
+		rebuild_pickups(world);
+	}
+	else if (world.tick != seen_tick + 1 || grid.edits != seen_edits) {
+		repair_pickups(world);
+	}
+	seen_tick = world.tick;
+	seen_edits = grid.edits;
+	update_danger(world);
+	update_hunt(world);
+	counters.updates += 1;
+}
+
+static uint64_t pickup_word(const gamegrid::GameGrid& grid, std::size_t w, std::size_t y) {
+	return gamegrid::word(grid, gamegrid::StateType::powerup_ammo, w, y) |
+	       gamegrid::word(grid, gamegrid::StateType::powerup_bomb, w, y);
+}
+
+void Bot_Fields::rebuild_pickups(const game::World& world) {
+	auto&& grid = world.grid;
+	width = grid.width;
+	height = grid.height;
+	words = grid.chunks_x;
+	revision = grid.revision;
+	built = true;
+
+	open.assign(words * height, 0);
+	pickups.assign(words * height, 0);
+	for (std::size_t y = 0; y < height; ++y) {
+		for (std::size_t w = 0; w < words; ++w) {
+			auto used = width - w * 64;
+			auto mask = used < 64 ? (uint64_t(1) << used) - 1 : ~uint64_t(0);
+			open[y * words + w] = ~gamegrid::word(grid, gamegrid::StateType::trap, w, y) & mask;
+			pickups[y * words + w] = pickup_word(grid, w, y);
+		}
+	}
+
+	exits.assign(width * height, 0);
+	for (std::size_t cell = 0; cell < width * height; ++cell) {
+		auto x = cell % width;
+		exits[cell] = static_cast<uint8_t>((x > 0 && walkable(cell - 1)) |
+		                                   (x + 1 < width && walkable(cell + 1)) << 1 |
+		                                   (cell >= width && walkable(cell - width)) << 2 |
+		                                   (cell + width < width * height &&
+		                                    walkable(cell + width)) << 3);
+	}
+
+	// Everything derived from the old layout goes
+	danger.assign(words * height, 0);
+	escape.assign(width * height, unreachable);
+	danger_cells.clear();
+	hunt.assign(width * height, hunt_cell{});
+	hunt_buckets.resize(hunt_radius + 1u);
+	hunt_built = false;
+
+	pickup.assign(width * height, unreachable);
+	if (buckets.empty()) {
+		buckets.resize(1);
+	}
+	for (std::size_t i = 0; i < pickups.size(); ++i) {
+		for (auto bits = pickups[i]; bits != 0; bits &= bits - 1) {
+			auto cell = (i / words) * width + (i % words) * 64 +
+			            static_cast<std::size_t>(gamegrid::lowest_bit(bits));
+			pickup[cell] = 0;
+			buckets[0].push_back(static_cast<uint32_t>(cell));
+		}
+	}
+	spread_pickups();
+	counters.pickup_rebuilds += 1;
+}
+
+// Powerups only disappear when taken and only appear when the grid is regenerated,
+// but both are handled. Distances can only grow around a powerup that went away:
+// every cell that may have been reached through it is thrown away and filled in
+// again from the cells around them that kept their distance.
+void Bot_Fields::repair_pickups(const game::World& world) {
+	auto&& grid = world.grid;
+	frontier.clear();
+	for (std::size_t y = 0; y < height; ++y) {
+		for (std::size_t w = 0; w < words; ++w) {
+			auto&& known = pickups[y * words + w];
+			auto now = pickup_word(grid, w, y);
+			if (now == known) {
+				continue;
+			}
+			auto base = y * width + w * 64;
+			for (auto bits = known & ~now; bits != 0; bits &= bits - 1) {
+				auto cell = base + static_cast<std::size_t>(gamegrid::lowest_bit(bits));
+				invalid.emplace_back(static_cast<uint32_t>(cell), pickup[cell]);
+				pickup[cell] = unreachable;
+			}
+			for (auto bits = now & ~known; bits != 0; bits &= bits - 1) {
+				auto cell = base + static_cast<std::size_t>(gamegrid::lowest_bit(bits));
+				frontier.push_back(static_cast<uint32_t>(cell));
+			}
+			known = now;
+		}
+	}
+	if (invalid.empty() && frontier.empty()) {
+		return;
+	}
+
+	for (std::size_t i = 0; i < invalid.size(); ++i) {
+		auto from = invalid[i];
+		auto next = static_cast<uint16_t>(from.second + 1);
+		for_each_neighbour(from.first, [&](std::size_t n) {
+			if (pickup[n] == next) {
+				invalid.emplace_back(static_cast<uint32_t>(n), next);
+				pickup[n] = unreachable;
+			}
+		});
+	}
+	for (auto&& entry : invalid) {
+		uint16_t best = unreachable;
+		for_each_neighbour(entry.first, [&](std::size_t n) {
+			if (pickup[n] != unreachable) {
+				best = std::min(best, static_cast<uint16_t>(pickup[n] + 1));
+			}
+		});
+		if (best != unreachable) {
+			pickup[entry.first] = best;
+			if (best >= buckets.size()) {
+				buckets.resize(best + 1u);
+			}
+			buckets[best].push_back(entry.first);
+		}
+	}
+	for (auto cell : frontier) {
+		pickup[cell] = 0;
+		buckets[0].push_back(cell);
+	}
+
+	counters.repaired_cells += invalid.size();
+	counters.pickup_repairs += 1;
+	invalid.clear();
+	spread_pickups();
+}
+
+void Bot_Fields::spread_pickups() {
+	for (std::size_t d = 0; d < buckets.size(); ++d) {
+		auto next = static_cast<uint16_t>(std::min<std::size_t>(d + 1, unreachable - 1));
+		for (std::size_t i = 0; i < buckets[d].size(); ++i) {
+			auto cell = buckets[d][i];
+			if (pickup[cell] != d) {
+				continue;
+			}
+			for_each_neighbour(cell, [&](std::size_t n) {
+				if (pickup[n] > next) {
+					pickup[n] = next;
+					if (next >= buckets.size()) {
+						buckets.resize(next + 1u);
+					}
+					buckets[next].push_back(static_cast<uint32_t>(n));
+				}
+			});
+		}
+		buckets[d].clear();
+	}
+}
+
+void Bot_Fields::update_danger(const game::World& world) {
+	for (auto cell : danger_cells) {
+		danger[cell / width * words + cell % width / 64] = 0;
+	}
+	danger_cells.clear();
+
+	auto mark = [&](std::size_t x, std::size_t y) {
+		auto&& bits = danger[y * words + x / 64];
+		auto bit = uint64_t(1) << (x % 64);
+		if (!(bits & bit)) {
+			bits |= bit;
+			danger_cells.push_back(static_cast<uint32_t>(y * width + x));
+			escape[y * width + x] = unreachable;
+		}
+	};
+	// Live bombs will cover what their blast reaches now, going off ones cover their reach
+	auto&& bombs = world.bombs;
+	for (std::size_t i = 0; i < bombs.size(); ++i) {
+		auto bx = bombs.x[i];
+		auto by = bombs.y[i];
+		auto reach = bombs.live[i] ? bomb::blast_reach(world.grid, bx, by) : bombs.reach[i];
+		mark(bx, by);
+		for (std::size_t d = 0; d < 4; ++d) {
+			for (long k = 1; k <= reach[d]; ++k) {
+				mark(static_cast<std::size_t>(static_cast<long>(bx) + move_x[d] * k),
+				     static_cast<std::size_t>(static_cast<long>(by) + move_y[d] * k));
+			}
+		}
+	}
+	if (danger_cells.empty()) {
+		return;
+	}
+
+	// Steps out, spreading inward from the edge of the blasts
+	frontier.clear();
+	for (auto cell : danger_cells) {
+		bool edge = false;
+		for_each_neighbour(cell, [&](std::size_t n) {
+			edge |= !in_danger(n % width, n / width);
+		});
+		if (edge) {
+			escape[cell] = 1;
+			frontier.push_back(cell);
+		}
+	}
+	for (uint16_t d = 1; !frontier.empty(); ++d) {
+		next_frontier.clear();
+		for (auto cell : frontier) {
+			for_each_neighbour(cell, [&](std::size_t n) {
+				if (in_danger(n % width, n / width) && escape[n] == unreachable) {
+					escape[n] = static_cast<uint16_t>(d + 1);
+					next_frontier.push_back(static_cast<uint32_t>(n));
+				}
+			});
+		}
+		std::swap(frontier, next_frontier);
+	}
+}
+
+// Each cell holds the two players with the lowest (distance, slot) that reach it within
+// hunt_radius, a bot looks past itself to the second one. A cell only holds a player
+// when the cells on the way there do too, so only the entries spreading out from a
+// player's old cell go when it moves, and an entry pushed out by a closer player takes
+// the ones reached through it along. Cells that lost an entry are offered the players
+// of the cells around them again, and moved players spread from where they are now.
+void Bot_Fields::update_hunt(const game::World& world) {
+	std::array<uint32_t, control::max_players> from;
+	for (std::size_t i = 0; i < from.size(); ++i) {
+		auto&& ps = world.players;
+		from[i] = ps.active[i] ? static_cast<uint32_t>(ps.loc_y[i] * width + ps.loc_x[i])
+		                       : no_cell;
+	}
+	if (hunt_built && from == hunted_from) {
+		return;
+	}
+
+	auto find = [&](std::size_t cell, uint32_t player) {
+		auto&& hc = hunt[cell];
+		std::size_t k = 0;
+		while (k < hc.count && hc.player[k] != player) {
+			++k;
+		}
+		return k;
+	};
+	auto holds = [&](std::size_t cell, uint32_t player, uint16_t distance) {
+		auto k = find(cell, player);
+		return k < hunt[cell].count && hunt[cell].distance[k] == distance;
+	};
+	auto erase = [&](std::size_t cell, std::size_t k) {
+		auto&& hc = hunt[cell];
+		if (k == 0) {
+			hc.distance[0] = hc.distance[1];
+			hc.player[0] = hc.player[1];
+		}
+		hc.count -= 1;
+	};
+	// Entries are the cell shifted up a byte with the player in the low byte, queued by
+	// the distance they would reach the cell at. Offers to cells that lost an entry are
+	// flagged, they can be out of date by the time their level comes. Levels below
+	// lowest are done with.
+	auto offer_around = [&](std::size_t cell, uint16_t lowest) {
+		for_each_neighbour(cell, [&](std::size_t n) {
+			auto&& kept = hunt[n];
+			for (std::size_t k = 0; k < kept.count; ++k) {
+				auto distance = kept.distance[k] + 1u;
+				if (distance >= lowest && distance <= hunt_radius &&
+				    find(cell, kept.player[k]) == hunt[cell].count) {
+					hunt_buckets[distance].push_back(static_cast<uint32_t>(cell) << 8 | offer |
+					                                 kept.player[k]);
+				}
+			}
+		});
+	};
+	// Throws away the entries of player reached through cell, which held it at distance
+	auto drop = [&](std::size_t cell, uint32_t player, uint16_t distance, uint16_t lowest) {
+		dropped.clear();
+		dropped.emplace_back(static_cast<uint32_t>(cell), distance);
+		for (std::size_t i = 0; i < dropped.size(); ++i) {
+			auto next = static_cast<uint16_t>(dropped[i].second + 1);
+			for_each_neighbour(dropped[i].first, [&](std::size_t n) {
+				auto k = find(n, player);
+				if (k < hunt[n].count && hunt[n].distance[k] == next) {
+					erase(n, k);
+					dropped.emplace_back(static_cast<uint32_t>(n), next);
+				}
+			});
+		}
+		for (auto&& entry : dropped) {
+			if (hunt[entry.first].count < 2) {
+				offer_around(entry.first, lowest);
+			}
+		}
+		counters.hunt_cells += dropped.size();
+	};
+
+	if (!hunt_built) {
+		hunt_built = true;
+		counters.hunt_rebuilds += 1;
+	}
+	else {
+		for (std::size_t i = 0; i < from.size(); ++i) {
+			auto was = hunted_from[i];
+			auto player = static_cast<uint32_t>(i);
+			if (was != from[i] && was != no_cell && holds(was, player, 0)) {
+				erase(was, find(was, player));
+				drop(was, player, 0, 1);
+			}
+		}
+		counters.hunt_repairs += 1;
+	}
+	// Players that didn't move go in again too, one sharing a cell with two others may
+	// only be held there now
+	for (std::size_t i = 0; i < from.size(); ++i) {
+		if (from[i] != no_cell && walkable(from[i])) {
+			hunt_buckets[0].push_back(from[i] << 8 | static_cast<uint32_t>(i));
+		}
+	}
+	hunted_from = from;
+
+	// Offers are only taken while a neighbour still holds the player a step closer
+	auto reach = [&](std::size_t cell, uint32_t player, uint16_t distance, bool offered) {
+		auto&& hc = hunt[cell];
+		if (find(cell, player) < hc.count) {
+			return false;
+		}
+		if (offered) {
+			bool through = false;
+			for_each_neighbour(cell, [&](std::size_t n) {
+				through = through || holds(n, player, static_cast<uint16_t>(distance - 1));
+			});
+			if (!through) {
+				return false;
+			}
+		}
+		auto entry = std::make_pair(distance, static_cast<uint8_t>(player));
+		auto k = std::size_t(hc.count);
+		auto pushed_out = hc.count == 2;
+		auto last = std::make_pair(hc.distance[1], hc.player[1]);
+		if (pushed_out) {
+			if (last < entry) {
+				return false;
+			}
+			k = 1;
+		}
+		else {
+			hc.count += 1;
+		}
+		for (; k > 0 && entry < std::make_pair(hc.distance[k - 1], hc.player[k - 1]); --k) {
+			hc.distance[k] = hc.distance[k - 1];
+			hc.player[k] = hc.player[k - 1];
+		}
+		hc.distance[k] = distance;
+		hc.player[k] = static_cast<uint8_t>(player);
+		if (pushed_out) {
+			drop(cell, last.second, last.first, static_cast<uint16_t>(distance + 1));
+		}
+		return true;
+	};
+	// A level's entries all go in before any spreads on. Entries closer than the level
+	// are settled, so cells already holding two of them are passed over.
+	for (uint16_t d = 0; d <= hunt_radius; ++d) {
+		frontier.clear();
+		for (std::size_t i = 0; i < hunt_buckets[d].size(); ++i) {
+			auto entry = hunt_buckets[d][i];
+			if (reach(entry >> 8, entry & player_bits, d, entry & offer)) {
+				frontier.push_back(entry & ~offer);
+			}
+		}
+		hunt_buckets[d].clear();
+		if (d == hunt_radius) {
+			break;
+		}
+		auto next = static_cast<uint16_t>(d + 1);
+		for (auto entry : frontier) {
+			auto player = entry & player_bits;
+			if (!holds(entry >> 8, player, d)) {
+				continue;
+			}
+			for_each_neighbour(entry >> 8, [&](std::size_t n) {
+				auto&& hc = hunt[n];
+				if (find(n, player) < hc.count || (hc.count == 2 && hc.distance[1] < next)) {
+					return;
+				}
+				hunt_buckets[next].push_back(static_cast<uint32_t>(n) << 8 | player);
+			});
+		}
+	}
+}
+
+// Whether a move from (x, y) stays on the grid, and where it ends
+static bool step(const gamegrid::GameGrid& grid, std::size_t x, std::size_t y, std::size_t d,
+                 std::size_t& to_x, std::size_t& to_y) {
+	auto nx = static_cast<long>(x) + move_x[d];
+	auto ny = static_cast<long>(y) + move_y[d];
+	if (nx < 0 || ny < 0 || nx >= static_cast<long>(grid.width) ||
+	    ny >= static_cast<long>(grid.height)) {
+		return false;
+	}
+	to_x = static_cast<std::size_t>(nx);
+	to_y = static_cast<std::size_t>(ny);
+	return true;
+}
+
+// A move that doesn't end on a trap or, unless already in one, in a blast
+static bool safe_move(const game::World& world, const Bot_Fields& fields, std::size_t x,
+                      std::size_t y, std::size_t d, std::size_t& to_x, std::size_t& to_y) {
+	return step(world.grid, x, y, d, to_x, to_y) &&
+	       !gamegrid::test(world.grid, gamegrid::StateType::trap, to_x, to_y) &&
+	       (fields.in_danger(x, y) || !fields.in_danger(to_x, to_y));
+}
+
+// Whether another player stands within shot_range in direction d with no trap between
+static bool lined_up(const game::World& world, const Bot_Fields& fields, std::size_t slot,
+                     std::size_t x, std::size_t y, std::size_t d) {
+	for (long k = 0; k < shot_range; ++k) {
+		if (!step(world.grid, x, y, d, x, y) ||
+		    gamegrid::test(world.grid, gamegrid::StateType::trap, x, y)) {
+			return false;
+		}
+		if (fields.hunt_distance(x, y, slot) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// The safe move with the lowest score, none if no move scores below limit
+template <class Score>
+static direction best_move(const game::World& world, const Bot_Fields& fields, std::size_t x,
+                           std::size_t y, std::size_t first, uint16_t limit, Score&& score) {
+	auto best = direction::none;
+	for (std::size_t k = 0; k < moves.size(); ++k) {
+		auto d = (first + k) % moves.size();
+		std::size_t to_x, to_y;
+		if (!safe_move(world, fields, x, y, d, to_x, to_y)) {
+			continue;
+		}
+		auto value = score(to_x, to_y);
+		if (value < limit) {
+			limit = value;
+			best = moves[d];
+		}
+	}
+	return best;
+}
+
+static std::size_t move_index(players::player_info::direction facing) {
+	switch (facing) {
+		case players::player_info::direction::left:
+			return 0;
+		case players::player_info::direction::right:
+			return 1;
+		case players::player_info::direction::up:
+			return 2;
+		case players::player_info::direction::down:
+			return 3;
+		default:
+			return 0;
+	}
+}
+
+control::controller_report bot::decide(const game::World& world, const Bot_Fields& fields,
+                                       std::size_t slot) {
+	control::controller_report report = {};
+	report.left_stick_dir = direction::none;
+	report.right_stick_dir = direction::none;
+	report.active = true;
+
+	auto p = world.players.get(slot);
+	if (!p.active) {
+		return report;
+	}
+	auto x = p.loc_x;
+	auto y = p.loc_y;
+	auto facing = move_index(p.dir);
+	report.rtrigger = p.ammo_count >= 1 && world.tick >= p.bullet_ready &&
+	                  lined_up(world, fields, slot, x, y, facing);
+	if (p.animated) {
+		return report;
+	}
+
+	// Bots try their moves starting from a different side each, so they spread out
+	// instead of all going the same way on ties
+	auto first = (slot + world.tick / 64) % moves.size();
+	if (fields.in_danger(x, y)) {
+		report.left_stick_dir = best_move(
+		    world, fields, x, y, first, fields.escape_distance(x, y),
+		    [&](std::size_t to_x, std::size_t to_y) { return fields.escape_distance(to_x, to_y); });
+		return report;
+	}
+
+	auto hunt = fields.hunt_distance(x, y, slot);
+	if (p.power == players::player_info::powerup::bomb && world.tick >= p.bomb_ready &&
+	    hunt <= 2) {
+		report.ltrigger = true;
+		return report;
+	}
+
+	// Turning means moving, so a bot steps toward a player lined up to its side
+	for (std::size_t d = 0; d < moves.size(); ++d) {
+		std::size_t to_x, to_y;
+		if (d != facing && lined_up(world, fields, slot, x, y, d) &&
+		    safe_move(world, fields, x, y, d, to_x, to_y)) {
+			report.left_stick_dir = moves[d];
+			return report;
+		}
+	}
+
+	if (hunt != Bot_Fields::unreachable && hunt > 0) {
+		report.left_stick_dir = best_move(
+		    world, fields, x, y, first, hunt, [&](std::size_t to_x, std::size_t to_y) {
+			    return fields.hunt_distance(to_x, to_y, slot);
+		    });
+		if (report.left_stick_dir != direction::none) {
+			return report;
+		}
+	}
+
+	auto pickup = fields.pickup_distance(x, y);
+	if (pickup != Bot_Fields::unreachable && pickup > 0) {
+		report.left_stick_dir = best_move(
+		    world, fields, x, y, first, pickup, [&](std::size_t to_x, std::size_t to_y) {
+			    return fields.pickup_distance(to_x, to_y);
+		    });
+		if (report.left_stick_dir != direction::none) {
+			return report;
+		}
+	}
+
+	// Nothing to go for, wander
+	report.left_stick_dir = best_move(world, fields, x, y, first, Bot_Fields::unreachable,
+	                                  [](std::size_t, std::size_t) { return uint16_t(0); });
+	return report;
+}
+
+void bot::drive(const game::World& world, Bot_Fields& fields,
+                control::movement_report_type& report, std::size_t players) {
+	fields.update(world);
+	for (std::size_t slot = 0; slot < std::min(players, report.size()); ++slot) {
+		if (!report[slot].active) {
+			report[slot] = decide(world, fields, slot);
+		}
+	}
+}
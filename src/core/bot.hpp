@@ -0,0 +1,129 @@
+#pragma once
+
+#include "controller_report.hpp"
+
+#include <array>
+#include <cinttypes>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace game {
+	struct World;
+}
+
+// Distance fields every bot steers by, over the cells that can be walked on:
+//   pickups  steps to the nearest powerup
+//   escape   steps out of the blast of any bomb, only kept inside blasts
+//   hunt     steps to the two nearest players, only kept within hunt_radius
+// They belong to one world and are brought up to date once per tick for every bot.
+// Taking a powerup only repairs the cells that were nearest to it and a player moving
+// only the cells that held it, a full rebuild happens when traps move or the grid
+// changes size. Every field is a function of the world alone, so bots make the same
+// decisions after a rollback or in a replay.
+class Bot_Fields {
+  public:
+	static constexpr uint16_t unreachable = 0xFFFF;
+	static constexpr uint16_t hunt_radius = 16;
+
+	struct stats {
+		uint64_t updates = 0;
+		uint64_t pickup_rebuilds = 0;
+		uint64_t pickup_repairs = 0;
+		// Cells whose pickup distance was thrown away and found again by repairs
+		uint64_t repaired_cells = 0;
+		uint64_t hunt_rebuilds = 0;
+		uint64_t hunt_repairs = 0;
+		// Hunt entries thrown away and found again by repairs
+		uint64_t hunt_cells = 0;
+	};
+
+	void update(const game::World& world);
+
+	uint16_t pickup_distance(std::size_t x, std::size_t y) const {
+		return pickup[y * width + x];
+	}
+	bool in_danger(std::size_t x, std::size_t y) const {
+		return (danger[y * words + x / 64] >> (x % 64)) & 1;
+	}
+	// 0 outside blasts, unreachable inside one with no way out
+	uint16_t escape_distance(std::size_t x, std::size_t y) const {
+		return in_danger(x, y) ? escape[y * width + x] : 0;
+	}
+	// Steps to the nearest player other than self, unreachable past hunt_radius
+	uint16_t hunt_distance(std::size_t x, std::size_t y, std::size_t self) const;
+
+	const stats& get_stats() const {
+		return counters;
+	}
+
+  private:
+	struct hunt_cell {
+		std::array<uint16_t, 2> distance;
+		std::array<uint8_t, 2> player;
+		uint8_t count;
+	};
+
+	void rebuild_pickups(const game::World& world);
+	void repair_pickups(const game::World& world);
+	// Lowers distances outward from the cells queued in buckets
+	void spread_pickups();
+	void update_danger(const game::World& world);
+	void update_hunt(const game::World& world);
+
+	bool walkable(std::size_t cell) const {
+		return (open[cell / width * words + cell % width / 64] >> (cell % width % 64)) & 1;
+	}
+	template <class F>
+	void for_each_neighbour(std::size_t cell, F&& f) const;
+
+	std::size_t width = 0, height = 0;
+	// 64 cell words per row, like the grid's planes
+	std::size_t words = 0;
+	uint32_t revision = 0;
+	bool built = false;
+	// Tick and grid edits of the last update. Powerups are only looked for again if the
+	// grid was edited since, or if the world isn't the one from the tick before.
+	uint32_t seen_tick = 0;
+	uint32_t seen_edits = 0;
+
+	std::vector<uint64_t> open;
+	// Walkable neighbours of each cell, a bit per move in the order they are visited
+	std::vector<uint8_t> exits;
+	// Powerups the pickup field was last brought up to date with
+	std::vector<uint64_t> pickups;
+	std::vector<uint16_t> pickup;
+	// Cells queued by distance while spreading
+	std::vector<std::vector<uint32_t>> buckets;
+	// Cells thrown away by a repair and the distance each had
+	std::vector<std::pair<uint32_t, uint16_t>> invalid;
+
+	std::vector<uint64_t> danger;
+	std::vector<uint16_t> escape;
+	std::vector<uint32_t> danger_cells;
+
+	std::vector<hunt_cell> hunt;
+	bool hunt_built = false;
+	// Cell each player was hunted from, so only the players that moved are looked at
+	std::array<uint32_t, control::max_players> hunted_from;
+	// Entries queued by distance while spreading
+	std::vector<std::vector<uint32_t>> hunt_buckets;
+	// Cells a player's entry was thrown away from and the distance it had
+	std::vector<std::pair<uint32_t, uint16_t>> dropped;
+	std::vector<uint32_t> frontier, next_frontier;
+
+	stats counters;
+};
+
+// Players for the slots nobody controls. Bots run from blasts, shoot at players
+// lined up with them, bomb players that come close, and otherwise go for the nearest
+// player within Bot_Fields::hunt_radius or the nearest powerup.
+namespace bot {
+	// Input for the player in slot from the fields of this tick
+	control::controller_report decide(const game::World& world, const Bot_Fields& fields,
+	                                  std::size_t slot);
+	// Updates the fields and replaces every inactive controller of the first players
+	// slots with a bot's input
+	void drive(const game::World& world, Bot_Fields& fields,
+	           control::movement_report_type& report, std::size_t players);
+}
@@ -0,0 +1,257 @@
+#include "bullet.hpp"
+#include "game.hpp"
+#include "gamegrid.hpp"
+#include "player.hpp"
+#include "spatial_index.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+Entity bullet::add_bullet(game::World& world, std::size_t owner, float pos_x, float pos_y,
+                          float vel_x, float vel_y, float lifespan) {
+	bullet_data bd;
+	bd.loc_x = pos_x;
+	bd.loc_y = pos_y;
+	bd.vel_x = vel_x;
+	bd.vel_y = vel_y;
+	bd.lifespan = lifespan;
+	bd.owner = owner;
+	bd.id = world.next_id;
+
+	constexpr float offset = 1.01f;
+	if (std::abs(vel_x) > std::abs(vel_y)) {
+		if (vel_x > 0) {
+			bd.loc_x += offset;
+			bd.dir = bullet_data::direction::right;
+		}
+		else {
+			bd.loc_x -= offset;
+			bd.dir = bullet_data::direction::left;
+		}
+	}
+	else {
+		if (vel_y > 0) {
+			bd.loc_y += offset;
+			bd.dir = bullet_data::direction::down;
+		}
+		else {
+			bd.loc_y -= offset;
+			bd.dir = bullet_data::direction::up;
+		}
+	}
+
+	bd.prev_x = bd.loc_x;
+	bd.prev_y = bd.loc_y;
+
+	// A full store drops the shot and counts it
+	auto handle = world.bullets.push_back(bd);
+	if (handle.slot != no_entity.slot) {
+		world.next_id += 1;
+	}
+	return handle;
+}
+
+// Players move at most one cell per step, their animation factor is clamped
+static constexpr float max_player_step = 1.0f;
+
+struct sweep_result {
+	// Fraction of the step at which the bullet stopped, 1 if it didn't
+	double time = 1.0;
+	bool trap = false;
+	bool outside = false;
+};
+
+// Walks every cell the bullet passes through between prev and loc in order (DDA),
+// stopping at the first trap or at the edge of the grid. Cells are centered on
+// integer coordinates, so the walk happens in coordinates shifted by half a cell.
+static sweep_result sweep_cells(const gamegrid::GameGrid& grid, float x0, float y0, float x1,
+                                float y1) {
+	double ax = x0 + 0.5, ay = y0 + 0.5;
+	double dx = static_cast<double>(x1) - x0, dy = static_cast<double>(y1) - y0;
+
+	double base_x = std::floor(ax), base_y = std::floor(ay);
+	auto cx = static_cast<long>(base_x);
+	auto cy = static_cast<long>(base_y);
+	long step_x = dx > 0 ? 1 : -1;
+	long step_y = dy > 0 ? 1 : -1;
+
+	constexpr double never = std::numeric_limits<double>::infinity();
+	double delta_x = dx != 0 ? std::abs(1.0 / dx) : never;
+	double delta_y = dy != 0 ? std::abs(1.0 / dy) : never;
+	double next_x = dx > 0 ? (base_x + 1 - ax) / dx : dx < 0 ? (ax - base_x) / -dx : never;
+	double next_y = dy > 0 ? (base_y + 1 - ay) / dy : dy < 0 ? (ay - base_y) / -dy : never;
+
+	double t = 0.0;
+	sweep_result result;
+	while (true) {
+		if (cx < 0 || cy < 0 || cx >= static_cast<long>(grid.width) ||
+		    cy >= static_cast<long>(grid.height)) {
+			result.time = t;
+			result.outside = true;
+			return result;
+		}
+		if (gamegrid::test(grid, gamegrid::StateType::trap, static_cast<std::size_t>(cx),
+		                   static_cast<std::size_t>(cy))) {
+			result.time = t;
+			result.trap = true;
+			return result;
+		}
+
+		if (next_x < next_y) {
+			t = next_x;
+			next_x += delta_x;
+			cx += step_x;
+		}
+		else {
+			t = next_y;
+			next_y += delta_y;
+			cy += step_y;
+		}
+		if (t > 1.0) {
+			return result;
+		}
+	}
+}
+
+// Earliest fraction of the step at which a point moving from d by v is inside a box
+// of half size r around the origin, or a negative value if it never is
+static double time_of_impact(double d_x, double d_y, double v_x, double v_y, double r) {
+	double enter = 0.0;
+	double leave = 1.0;
+	auto clip = [&](double d, double v) {
+		if (v == 0.0) {
+			if (std::abs(d) >= r) {
+				leave = -1.0;
+			}
+			return;
+		}
+		double t1 = (-r - d) / v;
+		double t2 = (r - d) / v;
+		enter = std::max(enter, std::min(t1, t2));
+		leave = std::min(leave, std::max(t1, t2));
+	};
+	clip(d_x, v_x);
+	clip(d_y, v_y);
+
+	return enter < leave ? enter : -1.0;
+}
+
+void bullet::update_bullets(game::World& world, float time_elapsed) {
+	auto&& grid = world.grid;
+	auto&& bullets = world.bullets;
+
+	integrate(bullets.columns(), time_elapsed, grid.width, grid.height);
+
+	// Bullets can cross several cells in one step at low tick rates, so the whole path
+	// is checked instead of the cell they end up in. Players are tested against their
+	// interpolated motion over the same step.
+	for (std::size_t i = 0; i < bullets.size(); ++i) {
+		if (bullets.cell[i] == cell_expired) {
+			continue;
+		}
+
+		float x0 = bullets.prev_x[i], y0 = bullets.prev_y[i];
+		float x1 = bullets.loc_x[i], y1 = bullets.loc_y[i];
+		auto blocked = sweep_cells(grid, x0, y0, x1, y1);
+
+		// Anyone close enough to the path to touch it during the step
+		constexpr float reach = static_cast<float>(spatial::player_radius) + max_player_step;
+		double impact = -1.0;
+		std::size_t victim = players::no_player;
+		spatial::players_in_box(
+		    world.index, grid.width, grid.height, std::min(x0, x1) - reach,
+		    std::min(y0, y1) - reach, std::max(x0, x1) + reach, std::max(y0, y1) + reach,
+		    [&](const spatial::entry& e) {
+			    auto prev_x = world.players.prev_x[e.id];
+			    auto prev_y = world.players.prev_y[e.id];
+			    double toi = time_of_impact(static_cast<double>(x0) - prev_x,
+			                                static_cast<double>(y0) - prev_y,
+			                                static_cast<double>(x1 - x0) - (e.x - prev_x),
+			                                static_cast<double>(y1 - y0) - (e.y - prev_y),
+			                                spatial::player_radius);
+			    if (toi >= 0 && (victim == players::no_player || toi < impact ||
+			                     (toi == impact && e.id < victim))) {
+				    impact = toi;
+				    victim = e.id;
+			    }
+			});
+
+		if (victim != players::no_player && impact <= blocked.time) {
+			bullets.cell[i] = cell_removed;
+			players::kill(world, victim, bullets.owner[i]);
+		}
+		else if (blocked.trap) {
+			bullets.cell[i] = cell_removed;
+		}
+		else if (blocked.outside) {
+			bullets.cell[i] = cell_outside;
+		}
+	}
+
+	bullets.compact();
+}
+
+Entity bullet::bullet_store::push_back(const bullet_data& bd) {
+	auto i = entities.size();
+	auto handle = entities.create();
+	if (handle.slot == no_entity.slot) {
+		return handle;
+	}
+
+	loc_x[i] = bd.loc_x;
+	loc_y[i] = bd.loc_y;
+	prev_x[i] = bd.prev_x;
+	prev_y[i] = bd.prev_y;
+	vel_x[i] = bd.vel_x;
+	vel_y[i] = bd.vel_y;
+	lifespan[i] = bd.lifespan;
+	dir[i] = bd.dir;
+	owner[i] = bd.owner;
+	id[i] = bd.id;
+	cell[i] = cell_outside;
+	return handle;
+}
+
+bullet::bullet_data bullet::bullet_store::get(std::size_t index) const {
+	bullet_data bd;
+	bd.loc_x = loc_x[index];
+	bd.loc_y = loc_y[index];
+	bd.prev_x = prev_x[index];
+	bd.prev_y = prev_y[index];
+	bd.vel_x = vel_x[index];
+	bd.vel_y = vel_y[index];
+	bd.lifespan = lifespan[index];
+	bd.dir = dir[index];
+	bd.owner = owner[index];
+	bd.id = id[index];
+	return bd;
+}
+
+void bullet::bullet_store::move(std::size_t to, std::size_t from) {
+	loc_x[to] = loc_x[from];
+	loc_y[to] = loc_y[from];
+	prev_x[to] = prev_x[from];
+	prev_y[to] = prev_y[from];
+	vel_x[to] = vel_x[from];
+	vel_y[to] = vel_y[from];
+	lifespan[to] = lifespan[from];
+	dir[to] = dir[from];
+	owner[to] = owner[from];
+	id[to] = id[from];
+	cell[to] = cell[from];
+}
+
+void bullet::bullet_store::clear() {
+	entities.clear();
+}
+
+void bullet::bullet_store::compact() {
+	entities.compact(
+	    [&](std::size_t i) { return cell[i] != cell_expired && cell[i] != cell_removed; },
+	    [&](std::size_t to, std::size_t from) { move(to, from); });
+}
+
+bullet::bullet_columns bullet::bullet_store::columns() {
+	return bullet_columns{loc_x.data(), loc_y.data(), prev_x.data(), prev_y.data(),
+	                      vel_x.data(), vel_y.data(), lifespan.data(), cell.data(), size()};
+}
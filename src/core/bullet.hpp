@@ -0,0 +1,99 @@
+#pragma once
+
+#include "entity.hpp"
+
+#include <array>
+#include <cinttypes>
+#include <cstddef>
+
+#ifndef BOMBERMAN_MAX_BULLETS
+#define BOMBERMAN_MAX_BULLETS 128
+#endif
+
+namespace game {
+	struct World;
+}
+
+namespace bullet {
+	struct bullet_data {
+		enum class direction : uint8_t { up = 0, left = 1, down = 2, right = 3 };
+		float loc_x, loc_y;
+		// Location at the end of the previous tick, used to interpolate rendering
+		float prev_x, prev_y;
+		float vel_x, vel_y;
+		direction dir;
+		float lifespan;
+		std::size_t owner;
+		// Serial number from World::next_id
+		uint32_t id;
+	};
+
+	// Cell values written by integrate for bullets that don't map onto the grid, and by
+	// the collision checks for bullets that hit something
+	constexpr int32_t cell_outside = -1;
+	constexpr int32_t cell_expired = -2;
+	constexpr int32_t cell_removed = -3;
+
+	// Bullets alive at once, set with the BOMBERMAN_MAX_BULLETS CMake option. A player
+	// fires at most every half second and bullets live ten seconds, so four players
+	// never get near the default. Shots past it are dropped and counted.
+	constexpr std::size_t max_bullets = BOMBERMAN_MAX_BULLETS;
+
+	// The columns the movement step works on, wherever they are stored
+	struct bullet_columns {
+		float *loc_x, *loc_y;
+		float *prev_x, *prev_y;
+		float *vel_x, *vel_y;
+		float* lifespan;
+		int32_t* cell;
+		std::size_t count;
+
+		std::size_t size() const {
+			return count;
+		}
+	};
+
+	// Bullet archetype. Structure of arrays storage so the movement step can run over
+	// whole columns with SIMD, index i in every column is the same bullet and entities
+	// maps handles onto it. Fixed size so the world stays trivially copyable.
+	struct bullet_store {
+		template <class T>
+		using column = std::array<T, max_bullets>;
+
+		column<float> loc_x, loc_y;
+		column<float> prev_x, prev_y;
+		column<float> vel_x, vel_y;
+		column<float> lifespan;
+		column<bullet_data::direction> dir;
+		column<std::size_t> owner;
+		column<uint32_t> id;
+		// Grid cell (y * width + x) after the last integrate, or one of the cell_ values
+		column<int32_t> cell;
+		Entity_Table<max_bullets> entities;
+
+		std::size_t size() const {
+			return entities.size();
+		}
+
+		// no_entity, and nothing added, when the store is full
+		Entity push_back(const bullet_data& bd);
+		bullet_data get(std::size_t index) const;
+		void move(std::size_t to, std::size_t from);
+		void clear();
+		// Drops every expired or removed bullet in one pass, keeping the order of the rest
+		void compact();
+		bullet_columns columns();
+	};
+
+	// no_entity when there is no room for the bullet
+	Entity add_bullet(game::World& world, std::size_t owner, float pos_x, float pos_y,
+	                  float vel_x, float vel_y, float lifespan);
+	void update_bullets(game::World& world, float time_elapsed);
+
+	// Moves every bullet, ages it and finds the cell it landed in. integrate uses the
+	// widest vector unit the build targets, integrate_scalar is the plain fallback.
+	void integrate(const bullet_columns& bullets, float time_elapsed, std::size_t width,
+	               std::size_t height);
+	void integrate_scalar(const bullet_columns& bullets, float time_elapsed, std::size_t width,
+	                      std::size_t height);
+}
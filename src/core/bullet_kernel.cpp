@@ -0,0 +1,155 @@
+#include "bullet.hpp"
+
+#if defined(__AVX__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+// Movement step for the bullet store. Every lane does the same thing as the scalar
+// loop: prev = loc, loc += vel * dt, lifespan -= dt, then the nearest cell is found
+// by truncating loc + 0.5 once it is known to be inside the grid. The cell index
+// is built in float, which is exact for grids up to 2^24 cells.
+
+static void integrate_range(const bullet::bullet_columns& bullets, std::size_t begin,
+                            std::size_t end, float time_elapsed, std::size_t width,
+                            std::size_t height) {
+	const auto width_f = static_cast<float>(width);
+	const auto height_f = static_cast<float>(height);
+
+	for (std::size_t i = begin; i < end; ++i) {
+		bullets.prev_x[i] = bullets.loc_x[i];
+		bullets.prev_y[i] = bullets.loc_y[i];
+		bullets.loc_x[i] += bullets.vel_x[i] * time_elapsed;
+		bullets.loc_y[i] += bullets.vel_y[i] * time_elapsed;
+		bullets.lifespan[i] -= time_elapsed;
+
+		float fx = bullets.loc_x[i] + 0.5f;
+		float fy = bullets.loc_y[i] + 0.5f;
+
+		if (bullets.lifespan[i] < 0) {
+			bullets.cell[i] = bullet::cell_expired;
+		}
+		else if (0 <= fx && fx < width_f && 0 <= fy && fy < height_f) {
+			bullets.cell[i] =
+			    static_cast<int32_t>(static_cast<int32_t>(fy) * static_cast<int32_t>(width) +
+			                         static_cast<int32_t>(fx));
+		}
+		else {
+			bullets.cell[i] = bullet::cell_outside;
+		}
+	}
+}
+
+void bullet::integrate_scalar(const bullet_columns& bullets, float time_elapsed,
+                              std::size_t width, std::size_t height) {
+	integrate_range(bullets, 0, bullets.size(), time_elapsed, width, height);
+}
+
+#if defined(__AVX__)
+
+void bullet::integrate(const bullet_columns& bullets, float time_elapsed, std::size_t width,
+                       std::size_t height) {
+	const std::size_t count = bullets.size();
+	const std::size_t vector_end = count - count % 8;
+
+	const __m256 dt = _mm256_set1_ps(time_elapsed);
+	const __m256 half = _mm256_set1_ps(0.5f);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 width_f = _mm256_set1_ps(static_cast<float>(width));
+	const __m256 height_f = _mm256_set1_ps(static_cast<float>(height));
+	const __m256 outside = _mm256_set1_ps(static_cast<float>(cell_outside));
+	const __m256 expired = _mm256_set1_ps(static_cast<float>(cell_expired));
+
+	for (std::size_t i = 0; i < vector_end; i += 8) {
+		__m256 x = _mm256_loadu_ps(&bullets.loc_x[i]);
+		__m256 y = _mm256_loadu_ps(&bullets.loc_y[i]);
+		_mm256_storeu_ps(&bullets.prev_x[i], x);
+		_mm256_storeu_ps(&bullets.prev_y[i], y);
+
+		x = _mm256_add_ps(x, _mm256_mul_ps(_mm256_loadu_ps(&bullets.vel_x[i]), dt));
+		y = _mm256_add_ps(y, _mm256_mul_ps(_mm256_loadu_ps(&bullets.vel_y[i]), dt));
+		__m256 life = _mm256_sub_ps(_mm256_loadu_ps(&bullets.lifespan[i]), dt);
+		_mm256_storeu_ps(&bullets.loc_x[i], x);
+		_mm256_storeu_ps(&bullets.loc_y[i], y);
+		_mm256_storeu_ps(&bullets.lifespan[i], life);
+
+		__m256 fx = _mm256_add_ps(x, half);
+		__m256 fy = _mm256_add_ps(y, half);
+		__m256 inside_x =
+		    _mm256_and_ps(_mm256_cmp_ps(fx, zero, _CMP_GE_OQ), _mm256_cmp_ps(fx, width_f, _CMP_LT_OQ));
+		__m256 inside_y = _mm256_and_ps(_mm256_cmp_ps(fy, zero, _CMP_GE_OQ),
+		                                _mm256_cmp_ps(fy, height_f, _CMP_LT_OQ));
+		__m256 inside = _mm256_and_ps(inside_x, inside_y);
+		__m256 dead = _mm256_cmp_ps(life, zero, _CMP_LT_OQ);
+
+		// Truncating a positive value is the same as flooring it
+		__m256 cx = _mm256_round_ps(fx, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+		__m256 cy = _mm256_round_ps(fy, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+		__m256 cell = _mm256_add_ps(_mm256_mul_ps(cy, width_f), cx);
+		cell = _mm256_blendv_ps(outside, cell, inside);
+		cell = _mm256_blendv_ps(cell, expired, dead);
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(&bullets.cell[i]),
+		                    _mm256_cvttps_epi32(cell));
+	}
+
+	integrate_range(bullets, vector_end, count, time_elapsed, width, height);
+}
+
+#elif defined(__SSE2__) || defined(_M_X64)
+
+void bullet::integrate(const bullet_columns& bullets, float time_elapsed, std::size_t width,
+                       std::size_t height) {
+	const std::size_t count = bullets.size();
+	const std::size_t vector_end = count - count % 4;
+
+	const __m128 dt = _mm_set1_ps(time_elapsed);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 width_f = _mm_set1_ps(static_cast<float>(width));
+	const __m128 height_f = _mm_set1_ps(static_cast<float>(height));
+	const __m128 outside = _mm_set1_ps(static_cast<float>(cell_outside));
+	const __m128 expired = _mm_set1_ps(static_cast<float>(cell_expired));
+
+	for (std::size_t i = 0; i < vector_end; i += 4) {
+		__m128 x = _mm_loadu_ps(&bullets.loc_x[i]);
+		__m128 y = _mm_loadu_ps(&bullets.loc_y[i]);
+		_mm_storeu_ps(&bullets.prev_x[i], x);
+		_mm_storeu_ps(&bullets.prev_y[i], y);
+
+		x = _mm_add_ps(x, _mm_mul_ps(_mm_loadu_ps(&bullets.vel_x[i]), dt));
+		y = _mm_add_ps(y, _mm_mul_ps(_mm_loadu_ps(&bullets.vel_y[i]), dt));
+		__m128 life = _mm_sub_ps(_mm_loadu_ps(&bullets.lifespan[i]), dt);
+		_mm_storeu_ps(&bullets.loc_x[i], x);
+		_mm_storeu_ps(&bullets.loc_y[i], y);
+		_mm_storeu_ps(&bullets.lifespan[i], life);
+
+		__m128 fx = _mm_add_ps(x, half);
+		__m128 fy = _mm_add_ps(y, half);
+		__m128 inside =
+		    _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(fx, zero), _mm_cmplt_ps(fx, width_f)),
+		               _mm_and_ps(_mm_cmpge_ps(fy, zero), _mm_cmplt_ps(fy, height_f)));
+		__m128 dead = _mm_cmplt_ps(life, zero);
+
+		// Truncating a positive value is the same as flooring it. Lanes outside the grid
+		// may overflow the conversion, they get masked below.
+		__m128 cx = _mm_cvtepi32_ps(_mm_cvttps_epi32(fx));
+		__m128 cy = _mm_cvtepi32_ps(_mm_cvttps_epi32(fy));
+		__m128 cell = _mm_add_ps(_mm_mul_ps(cy, width_f), cx);
+		// SSE2 has no blend, select with masks
+		cell = _mm_or_ps(_mm_and_ps(inside, cell), _mm_andnot_ps(inside, outside));
+		cell = _mm_or_ps(_mm_and_ps(dead, expired), _mm_andnot_ps(dead, cell));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&bullets.cell[i]), _mm_cvttps_epi32(cell));
+	}
+
+	integrate_range(bullets, vector_end, count, time_elapsed, width, height);
+}
+
+#else
+
+void bullet::integrate(const bullet_columns& bullets, float time_elapsed, std::size_t width,
+                       std::size_t height) {
+	integrate_scalar(bullets, time_elapsed, width, height);
+}
+
+#endif
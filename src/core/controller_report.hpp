@@ -0,0 +1,21 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+namespace control {
+	// Player slots in a match, each one fed by its own controller report
+	constexpr std::size_t max_players = 64;
+
+	struct controller_report {
+		enum class direction { none, up, down, left, right };
+		direction left_stick_dir;
+		direction right_stick_dir;
+		std::array<bool, 15> keys;
+		bool active;
+		bool ltrigger;
+		bool rtrigger;
+	};
+
+	using movement_report_type = std::array<controller_report, max_players>;
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cinttypes>
+#include <cstddef>
+
+// Handle to an entity of one archetype: the slot it was given and the generation the
+// slot was on at the time. Dense indices change as entities come and go, handles
+// don't. Freeing a slot moves its generation on, so old handles stop resolving.
+struct Entity {
+	uint32_t slot;
+	uint32_t generation;
+};
+
+constexpr Entity no_entity = {0xFFFFFFFF, 0};
+
+// Slot bookkeeping for an archetype: a store keeps its components in dense arrays,
+// index i of every array being the entity at dense index i, and this table maps the
+// handles onto those indices. Everything is inline and fixed size, so an archetype
+// stays trivially copyable and a zeroed table is an empty one. Creating and freeing
+// are O(1) and never allocate, a full table refuses new entities and counts them.
+template <std::size_t Capacity>
+class Entity_Table {
+  public:
+	static constexpr std::size_t capacity = Capacity;
+	static constexpr uint32_t npos = 0xFFFFFFFF;
+
+	// Slot for a new entity at dense index size(), no_entity when full
+	Entity create() {
+		if (count == Capacity) {
+			spawn_failures += 1;
+			return no_entity;
+		}
+		// Freed slots are kept past the live ones, fresh slots are handed out after them
+		auto slot = count < issued ? slots[count] : issued++;
+		slots[count] = slot;
+		dense[slot] = count;
+		count += 1;
+		high_water = count > high_water ? count : high_water;
+		return Entity{slot, generations[slot]};
+	}
+
+	// Dense index of the entity, npos once it is gone
+	uint32_t find(Entity e) const {
+		if (e.slot >= issued || generations[e.slot] != e.generation) {
+			return npos;
+		}
+		return dense[e.slot];
+	}
+	// Dense index of whatever lives in the slot now, for references such as timer
+	// events that can't outlive the entity they point at
+	uint32_t find_slot(uint32_t slot) const {
+		return dense[slot];
+	}
+	Entity handle(std::size_t index) const {
+		auto slot = slots[index];
+		return Entity{slot, generations[slot]};
+	}
+
+	std::size_t size() const {
+		return count;
+	}
+	bool full() const {
+		return count == Capacity;
+	}
+	// Most entities alive at once, and creates refused because the table was full.
+	// Only for tuning capacities. Snapshots copy them with the rest of the world, so
+	// a rollback or a forked world takes them back to the snapshot's counts, but
+	// replays and checksums leave them out.
+	uint32_t get_high_water() const {
+		return high_water;
+	}
+	uint32_t get_spawn_failures() const {
+		return spawn_failures;
+	}
+
+	void clear() {
+		for (uint32_t i = 0; i < count; ++i) {
+			generations[slots[i]] += 1;
+		}
+		count = 0;
+	}
+
+	// Keeps the entities keep(index) holds for, in order, and frees the rest. Calls
+	// move(to, from) for every kept entity whose dense index goes down, so the store
+	// can move its components along.
+	template <class Keep, class Move>
+	void compact(Keep&& keep, Move&& move) {
+		std::array<uint32_t, Capacity> freed;
+		uint32_t freed_count = 0;
+		uint32_t kept = 0;
+		for (uint32_t i = 0; i < count; ++i) {
+			auto slot = slots[i];
+			if (!keep(i)) {
+				generations[slot] += 1;
+				freed[freed_count++] = slot;
+				continue;
+			}
+			if (kept != i) {
+				move(kept, i);
+				slots[kept] = slot;
+				dense[slot] = kept;
+			}
+			kept += 1;
+		}
+		for (uint32_t k = 0; k < freed_count; ++k) {
+			slots[kept + k] = freed[k];
+		}
+		count = kept;
+	}
+
+	// Frees the entity at index and moves the last one into its place with move(to, from)
+	template <class Move>
+	void remove(std::size_t index, Move&& move) {
+		auto slot = slots[index];
+		auto last = count - 1;
+		if (index != last) {
+			move(index, last);
+			slots[index] = slots[last];
+			dense[slots[index]] = static_cast<uint32_t>(index);
+		}
+		slots[last] = slot;
+		generations[slot] += 1;
+		count = last;
+	}
+
+	// Visits every member for saving and loading, see replay.cpp
+	template <class Stream>
+	void transfer(Stream& stream) {
+		stream.value(count);
+		stream.value(issued);
+		if (count > issued || issued > Capacity) {
+			count = 0;
+			issued = 0;
+			stream.fail();
+		}
+		stream.bytes(slots.data(), issued * sizeof(uint32_t));
+		stream.bytes(dense.data(), issued * sizeof(uint32_t));
+		stream.bytes(generations.data(), issued * sizeof(uint32_t));
+		// Slots past issued have never been handed out, whatever table this was before
+		if (Stream::loading) {
+			std::fill(generations.begin() + issued, generations.end(), 0);
+		}
+	}
+
+  private:
+	// Dense index to slot. [0, count) are the live entities, [count, issued) are
+	// freed slots waiting to be reused.
+	std::array<uint32_t, Capacity> slots;
+	// Slot to dense index, and to how many times the slot has been freed
+	std::array<uint32_t, Capacity> dense;
+	std::array<uint32_t, Capacity> generations;
+	uint32_t count = 0;
+	uint32_t issued = 0;
+	uint32_t high_water = 0;
+	uint32_t spawn_failures = 0;
+};
+
+template <std::size_t Capacity>
+constexpr std::size_t Entity_Table<Capacity>::capacity;
+template <std::size_t Capacity>
+constexpr uint32_t Entity_Table<Capacity>::npos;
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <cinttypes>
+#include <cstddef>
+
+// Vector with its storage inline, so it is trivially copyable whenever T is and a
+// struct made of these can be copied with memcpy. push_back fails instead of growing.
+template <class T, std::size_t Capacity>
+class Fixed_Vector {
+  public:
+	static constexpr std::size_t capacity = Capacity;
+
+	// False, and nothing added, when full
+	bool push_back(const T& value) {
+		if (count == Capacity) {
+			return false;
+		}
+		items[count++] = value;
+		return true;
+	}
+	void pop_back() {
+		count -= 1;
+	}
+	void clear() {
+		count = 0;
+	}
+	// Only shrinks or grows into slots that were already written
+	void resize(std::size_t size) {
+		count = static_cast<uint32_t>(size);
+	}
+
+	std::size_t size() const {
+		return count;
+	}
+	bool empty() const {
+		return count == 0;
+	}
+	bool full() const {
+		return count == Capacity;
+	}
+
+	T& operator[](std::size_t index) {
+		return items[index];
+	}
+	const T& operator[](std::size_t index) const {
+		return items[index];
+	}
+	T& back() {
+		return items[count - 1];
+	}
+
+	T* data() {
+		return items.data();
+	}
+	const T* data() const {
+		return items.data();
+	}
+	T* begin() {
+		return items.data();
+	}
+	T* end() {
+		return items.data() + count;
+	}
+	const T* begin() const {
+		return items.data();
+	}
+	const T* end() const {
+		return items.data() + count;
+	}
+
+  private:
+	std::array<T, Capacity> items;
+	uint32_t count = 0;
+};
+
+template <class T, std::size_t Capacity>
+constexpr std::size_t Fixed_Vector<T, Capacity>::capacity;
@@ -0,0 +1,54 @@
+#include "game.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+void game::initialize(World& world, std::size_t width, std::size_t height, uint32_t seed) {
+	world.prng.seed(seed);
+	world.bullets.clear();
+	world.bombs.clear();
+	world.index = spatial::SpatialIndex{};
+	world.blast = bomb::blast_state{};
+	world.tick = 0;
+	world.next_id = 0;
+	world.timers.reset();
+	world.fired.clear();
+	world.kills.fill(0);
+	world.deaths.fill(0);
+
+	gamegrid::initialize(world, width, height);
+	players::initialize(world);
+}
+
+void game::update(World& world, const control::movement_report_type& report, float time_elapsed) {
+	world.tick += 1;
+	world.step = time_elapsed;
+	world.fired.clear();
+	world.timers.advance(world.tick, world.fired);
+
+	players::update_players(world, report);
+	spatial::index_players(world);
+	bullet::update_bullets(world, time_elapsed);
+	bomb::update_bombs(world);
+	gamegrid::read_controls(world, report);
+}
+
+uint32_t game::ticks_from_now(const World& world, float seconds) {
+	auto ticks = static_cast<uint32_t>(std::ceil(seconds / world.step));
+	return world.tick + std::max(ticks, 1u);
+}
+
+std::size_t game::snapshot_size(const World& world) {
+	return offsetof(World, grid) + offsetof(gamegrid::GameGrid, chunks) +
+	       gamegrid::chunk_count(world.grid) * sizeof(gamegrid::Chunk);
+}
+
+void game::save_snapshot(const World& world, void* out) {
+	std::memcpy(out, &world, snapshot_size(world));
+}
+
+void game::load_snapshot(World& world, const void* in, std::size_t size) {
+	std::memcpy(&world, in, size);
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "bomb.hpp"
+#include "bullet.hpp"
+#include "controller_report.hpp"
+#include "gamegrid.hpp"
+#include "player.hpp"
+#include "random.hpp"
+#include "spatial_index.hpp"
+#include "timer_wheel.hpp"
+
+#include <array>
+#include <cinttypes>
+#include <cstddef>
+#include <type_traits>
+
+namespace game {
+	// What a Timer_Wheel event refers to, its target is an index into the matching storage
+	enum class timer_kind : uint32_t { bomb_fuse, bomb_blast };
+
+	// Timers pending at once. Only bombs schedule them, one at a time: the fuse, then the
+	// blast once it has fired or been cancelled by a chain reaction.
+	constexpr std::size_t max_timers = bomb::max_bombs;
+	using timer_wheel = Timer_Wheel<max_timers>;
+
+	// Everything that changes during a match. Nothing in the core keeps state
+	// outside of this, so any number of matches can run side by side.
+	//
+	// The world is trivially copyable: every container has a fixed capacity and holds
+	// no pointers, so a copy of its bytes is a complete, independent world. The grid
+	// comes last and only its used chunks need copying, see snapshot_size.
+	struct World {
+		players::player_store players;
+		bullet::bullet_store bullets;
+		bomb::bomb_store bombs;
+
+		// Rebuilt every tick, only here so the buffers are reused
+		spatial::SpatialIndex index;
+		bomb::blast_state blast;
+
+		// Tick being simulated and its length in seconds
+		uint32_t tick = 0;
+		float step = 0;
+		timer_wheel timers;
+		// Events that expired at the start of this tick
+		timer_wheel::event_list fired;
+
+		Random prng;
+		// Serial number of the next bullet or bomb, so observers such as network
+		// clients can follow entities from one tick to the next
+		uint32_t next_id = 0;
+
+		std::array<uint32_t, control::max_players> kills = {};
+		std::array<uint32_t, control::max_players> deaths = {};
+
+		// Must stay the last member
+		gamegrid::GameGrid grid;
+	};
+
+	static_assert(std::is_trivially_copyable<World>::value, "worlds are copied as bytes");
+	static_assert(std::is_standard_layout<World>::value, "snapshot_size uses offsetof");
+
+	void initialize(World& world, std::size_t width, std::size_t height, uint32_t seed);
+	void update(World& world, const control::movement_report_type& report, float time_elapsed);
+
+	// Tick at which something lasting the given number of seconds from now is over
+	uint32_t ticks_from_now(const World& world, float seconds);
+
+	// Bytes from the start of the world that hold all of its state: everything up to
+	// the end of the last chunk the grid uses. Fixed for the length of a match.
+	std::size_t snapshot_size(const World& world);
+	// A snapshot is the first snapshot_size bytes of the world, copied with one memcpy.
+	// Restoring one overwrites the same bytes, the unused chunks are never looked at.
+	void save_snapshot(const World& world, void* out);
+	void load_snapshot(World& world, const void* in, std::size_t size);
+}
@@ -0,0 +1,203 @@
+#include "gamegrid.hpp"
+#include "game.hpp"
+#include "player.hpp"
+
+#include <algorithm>
+
+void gamegrid::initialize(game::World& world, std::size_t width, std::size_t height) {
+	auto&& grid = world.grid;
+	grid.width = std::min(std::max(width, std::size_t(3)), max_size);
+	grid.height = std::min(std::max(height, std::size_t(3)), max_size);
+	grid.chunks_x = (grid.width + chunk_size - 1) / chunk_size;
+	grid.chunks_y = (grid.height + chunk_size - 1) / chunk_size;
+	grid.revision = 0;
+	grid.edits = 0;
+	std::fill_n(grid.chunks.begin(), chunk_count(grid), Chunk{});
+
+	regenerate(world);
+}
+
+void gamegrid::read_controls(game::World& world, const typename control::movement_report_type& rt) {
+	if (std::any_of(rt.begin(), rt.end(),
+	                [](auto controller) { return controller.keys[6] && controller.active; })) {
+		regenerate(world);
+		for (std::size_t i = 0; i < world.players.size(); ++i) {
+			players::respawn(world, i);
+		}
+	}
+}
+
+void gamegrid::regenerate(game::World& world) {
+	auto&& grid = world.grid;
+
+	for (std::size_t x = 1; x < grid.width - 1; ++x) {
+		for (std::size_t y = 1; y < grid.height - 1; ++y) {
+			set(grid, x, y, static_cast<StateType>(world.prng.below(4)));
+		}
+	}
+}
+
+gamegrid::StateType gamegrid::get(const GameGrid& grid, std::size_t x, std::size_t y) {
+	for (std::size_t p = 0; p < plane_count; ++p) {
+		auto type = static_cast<StateType>(p + 1);
+		if (test(grid, type, x, y)) {
+			return type;
+		}
+	}
+	return StateType::empty;
+}
+
+void gamegrid::set(GameGrid& grid, std::size_t x, std::size_t y, StateType type) {
+	auto&& chunk = grid.chunks[(y / chunk_size) * grid.chunks_x + x / chunk_size];
+	auto row = y % chunk_size;
+	auto bit = uint64_t(1) << (x % chunk_size);
+	if (type == StateType::trap || test(grid, StateType::trap, x, y)) {
+		grid.revision += 1;
+	}
+	grid.edits += 1;
+	for (auto&& plane : chunk.planes) {
+		plane[row] &= ~bit;
+	}
+	if (type != StateType::empty) {
+		chunk.planes[static_cast<std::size_t>(type) - 1][row] |= bit;
+	}
+}
+
+std::size_t gamegrid::count(const GameGrid& grid, StateType type) {
+	std::size_t total = 0;
+	for (std::size_t c = 0; c < chunk_count(grid); ++c) {
+		for (auto bits : grid.chunks[c].planes[static_cast<std::size_t>(type) - 1]) {
+			total += static_cast<std::size_t>(popcount(bits));
+		}
+	}
+	return total;
+}
+
+std::size_t gamegrid::count_row(const GameGrid& grid, StateType type, std::size_t y) {
+	std::size_t total = 0;
+	for (std::size_t w = 0; w < grid.chunks_x; ++w) {
+		total += static_cast<std::size_t>(popcount(word(grid, type, w, y)));
+	}
+	return total;
+}
+
+bool gamegrid::row_clear(const GameGrid& grid, StateType type, std::size_t y) {
+	for (std::size_t w = 0; w < grid.chunks_x; ++w) {
+		if (word(grid, type, w, y) != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Occluded fills: spread gen through the set bits of open towards higher or lower
+// bits in log2(64) steps (Kogge-Stone)
+static uint64_t fill_up(uint64_t gen, uint64_t open) {
+	gen |= open & (gen << 1);
+	open &= open << 1;
+	gen |= open & (gen << 2);
+	open &= open << 2;
+	gen |= open & (gen << 4);
+	open &= open << 4;
+	gen |= open & (gen << 8);
+	open &= open << 8;
+	gen |= open & (gen << 16);
+	open &= open << 16;
+	gen |= open & (gen << 32);
+	return gen;
+}
+
+static uint64_t fill_down(uint64_t gen, uint64_t open) {
+	gen |= open & (gen >> 1);
+	open &= open >> 1;
+	gen |= open & (gen >> 2);
+	open &= open >> 2;
+	gen |= open & (gen >> 4);
+	open &= open >> 4;
+	gen |= open & (gen >> 8);
+	open &= open >> 8;
+	gen |= open & (gen >> 16);
+	open &= open >> 16;
+	gen |= open & (gen >> 32);
+	return gen;
+}
+
+// Cells of a row that aren't traps, without the padding past the last column
+static uint64_t open_word(const gamegrid::GameGrid& grid, std::size_t y, std::size_t w) {
+	auto open = ~gamegrid::word(grid, gamegrid::StateType::trap, w, y);
+	auto used = grid.width - w * 64;
+	if (used < 64) {
+		open &= (uint64_t(1) << used) - 1;
+	}
+	return open;
+}
+
+// Spreads the bits of one row sideways through open cells, across word boundaries
+static void fill_row(const gamegrid::GameGrid& grid, uint64_t* cells, std::size_t y) {
+	auto words = grid.chunks_x;
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		for (std::size_t w = 0; w < words; ++w) {
+			auto open = open_word(grid, y, w);
+			auto value = cells[w];
+			if (w > 0 && (cells[w - 1] >> 63)) {
+				value |= open & 1;
+			}
+			if (w + 1 < words && (cells[w + 1] & 1)) {
+				value |= open & (uint64_t(1) << 63);
+			}
+			value = fill_up(value, open) | fill_down(value, open);
+			if (value != cells[w]) {
+				cells[w] = value;
+				changed = true;
+			}
+		}
+	}
+}
+
+// Pulls cells in from a neighbouring row, then spreads them along the row
+static bool spread_row(const gamegrid::GameGrid& grid, std::vector<uint64_t>& out, std::size_t y,
+                       std::size_t from) {
+	auto words = grid.chunks_x;
+	auto cells = out.data() + y * words;
+	auto source = out.data() + from * words;
+
+	bool grew = false;
+	for (std::size_t w = 0; w < words; ++w) {
+		auto value = cells[w] | (source[w] & open_word(grid, y, w));
+		if (value != cells[w]) {
+			cells[w] = value;
+			grew = true;
+		}
+	}
+	if (grew) {
+		fill_row(grid, cells, y);
+	}
+	return grew;
+}
+
+void gamegrid::reachable(const GameGrid& grid, std::size_t x, std::size_t y,
+                         std::vector<uint64_t>& out) {
+	auto words = grid.chunks_x;
+	out.assign(words * grid.height, 0);
+	if (test(grid, StateType::trap, x, y)) {
+		return;
+	}
+
+	out[y * words + x / 64] = uint64_t(1) << (x % 64);
+	fill_row(grid, out.data() + y * words, y);
+
+	// Sweep down and up until nothing new is reached, each sweep carries every
+	// open run one row further in its direction
+	bool grew = true;
+	while (grew) {
+		grew = false;
+		for (std::size_t row_y = 1; row_y < grid.height; ++row_y) {
+			grew |= spread_row(grid, out, row_y, row_y - 1);
+		}
+		for (std::size_t row_y = grid.height - 1; row_y-- > 0;) {
+			grew |= spread_row(grid, out, row_y, row_y + 1);
+		}
+	}
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "controller_report.hpp"
+#include <array>
+#include <cinttypes>
+#include <cstddef>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace game {
+	struct World;
+}
+
+namespace gamegrid {
+	enum class StateType { empty = 0, powerup_ammo = 1, powerup_bomb = 2, trap = 3 };
+
+	// Bitboard storage: one bit plane for every non-empty StateType. A cell is empty
+	// when no plane has its bit set. The grid is cut into 64x64 chunks, so a row of a
+	// chunk is a single word and a chunk holds all of its planes in 1.5KB. Chunks are
+	// stored row by row, a 1024x1024 grid is 16x16 chunks and 384KB in total.
+	constexpr std::size_t plane_count = 3;
+	constexpr std::size_t chunk_size = 64;
+	constexpr std::size_t max_size = 1024;
+	constexpr std::size_t max_chunks = (max_size / chunk_size) * (max_size / chunk_size);
+
+	struct Chunk {
+		std::array<std::array<uint64_t, chunk_size>, plane_count> planes;
+	};
+
+	// Room for the largest grid is always there, only the first chunks_x * chunks_y
+	// chunks are used. They come last so a copy of the used part is one block.
+	struct GameGrid {
+		std::size_t width;
+		std::size_t height;
+		// Chunks across and down. Every grid row is also chunks_x words per plane.
+		std::size_t chunks_x, chunks_y;
+		// Bumped whenever the layout of traps changes, so derived tables know to rebuild
+		uint32_t revision = 0;
+		// Bumped by every set. Only meant to be compared with itself from one tick to the
+		// next, so replays don't keep it.
+		uint32_t edits = 0;
+		std::array<Chunk, max_chunks> chunks;
+	};
+
+	inline std::size_t chunk_count(const GameGrid& grid) {
+		return grid.chunks_x * grid.chunks_y;
+	}
+
+	inline int popcount(uint64_t word) {
+#ifdef _MSC_VER
+		return static_cast<int>(__popcnt64(word));
+#else
+		return __builtin_popcountll(word);
+#endif
+	}
+
+	inline int lowest_bit(uint64_t word) {
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward64(&index, word);
+		return static_cast<int>(index);
+#else
+		return __builtin_ctzll(word);
+#endif
+	}
+
+	// Cells [64 * w, 64 * w + 64) of row y, bit i being column 64 * w + i
+	inline uint64_t word(const GameGrid& grid, StateType type, std::size_t w, std::size_t y) {
+		auto&& chunk = grid.chunks[(y / chunk_size) * grid.chunks_x + w];
+		return chunk.planes[static_cast<std::size_t>(type) - 1][y % chunk_size];
+	}
+
+	inline bool test(const GameGrid& grid, StateType type, std::size_t x, std::size_t y) {
+		return (word(grid, type, x / 64, y) >> (x % 64)) & 1;
+	}
+
+	StateType get(const GameGrid& grid, std::size_t x, std::size_t y);
+	void set(GameGrid& grid, std::size_t x, std::size_t y, StateType type);
+
+	// Number of cells of a type, in the whole grid or in one row
+	std::size_t count(const GameGrid& grid, StateType type);
+	std::size_t count_row(const GameGrid& grid, StateType type, std::size_t y);
+	bool row_clear(const GameGrid& grid, StateType type, std::size_t y);
+
+	// Fills out with a plane of every cell that can be walked to from (x, y) without
+	// crossing a trap, chunks_x words per row. Spreads a whole row per step with shifts
+	// instead of cell by cell.
+	void reachable(const GameGrid& grid, std::size_t x, std::size_t y, std::vector<uint64_t>& out);
+
+	// Calls f(x, y) for every cell of the given type in one chunk, in row order
+	template <class F>
+	void for_each_in_chunk(const GameGrid& grid, StateType type, std::size_t chunk_x,
+	                       std::size_t chunk_y, F&& f) {
+		auto&& plane = grid.chunks[chunk_y * grid.chunks_x + chunk_x]
+		                   .planes[static_cast<std::size_t>(type) - 1];
+		for (std::size_t row = 0; row < chunk_size; ++row) {
+			for (uint64_t bits = plane[row]; bits != 0; bits &= bits - 1) {
+				f(chunk_x * chunk_size + static_cast<std::size_t>(lowest_bit(bits)),
+				  chunk_y * chunk_size + row);
+			}
+		}
+	}
+
+	// Calls f(x, y) for every cell of the given type, chunk by chunk
+	template <class F>
+	void for_each(const GameGrid& grid, StateType type, F&& f) {
+		for (std::size_t cy = 0; cy < grid.chunks_y; ++cy) {
+			for (std::size_t cx = 0; cx < grid.chunks_x; ++cx) {
+				for_each_in_chunk(grid, type, cx, cy, f);
+			}
+		}
+	}
+
+	// Width and height are clamped to [3, max_size]
+	void initialize(game::World& world, std::size_t width, std::size_t height);
+	void regenerate(game::World& world);
+	void read_controls(game::World& world, const control::movement_report_type& rt);
+}
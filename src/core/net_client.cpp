@@ -0,0 +1,103 @@
+#include "net_client.hpp"
+#include "replay.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+// Ticks between hellos while the server hasn't answered
+static constexpr uint32_t hello_interval = 30;
+
+Snapshot_Client::Snapshot_Client(const Udp_Socket::address& server_, uint32_t match_)
+    : server(server_), match(match_), datagram(net::max_datagram) {
+	view_ticks.fill(-1);
+}
+
+void Snapshot_Client::send(const control::controller_report& input) {
+	packet.clear();
+	if (!connected) {
+		if (hello_wait++ % hello_interval != 0) {
+			return;
+		}
+		packet.write(static_cast<uint32_t>(net::message::hello), net::message_bits);
+		packet.write(match, 16);
+	}
+	else {
+		auto report = input;
+		report.active = true;
+		packet.write(static_cast<uint32_t>(net::message::input), net::message_bits);
+		packet.write(static_cast<uint32_t>(newest), 32);
+		packet.write(replay::pack_report(report), replay::packed_bits);
+	}
+
+	auto&& bytes = packet.finish();
+	socket.send(server, bytes.data(), bytes.size());
+	counters.bytes_sent += bytes.size();
+}
+
+bool Snapshot_Client::receive() {
+	auto previous = newest;
+	Udp_Socket::address from;
+	while (auto size = socket.receive(from, datagram.data(), datagram.size())) {
+		if (from.host != server.host || from.port != server.port) {
+			continue;
+		}
+		counters.bytes_received += size;
+
+		Bit_Reader in(datagram.data(), size);
+		auto kind = static_cast<net::message>(in.read(net::message_bits));
+		if (kind == net::message::welcome && !connected) {
+			auto welcome_match = in.read(16);
+			auto welcome_slot = in.read(8);
+			uint32_t step_bits = in.read(32);
+			if (!in.overflowed()) {
+				match = welcome_match;
+				slot = welcome_slot;
+				std::memcpy(&step, &step_bits, sizeof(step));
+				connected = true;
+			}
+		}
+		else if (kind == net::message::snapshot && connected) {
+			read_snapshot(in);
+		}
+	}
+	return newest > previous;
+}
+
+void Snapshot_Client::read_snapshot(Bit_Reader& in) {
+	static const net::view empty;
+
+	auto back = in.read(6);
+	auto sum = in.read(32);
+	// The base is found from the tick, which comes first in the delta
+	Bit_Reader peek = in;
+	int64_t tick = peek.read(32);
+	int64_t base_tick = tick - back;
+	auto base_index = static_cast<std::size_t>(base_tick) % net::history;
+	if (back != 0 && (base_tick < 0 || view_ticks[base_index] != base_tick)) {
+		counters.rejected += 1;
+		return;
+	}
+
+	auto&& base = back == 0 ? empty : views[base_index];
+	if (!net::read_delta(in, base, decoded)) {
+		counters.rejected += 1;
+		return;
+	}
+	if (net::checksum(decoded) != sum) {
+		counters.mismatches += 1;
+		return;
+	}
+
+	counters.snapshots += 1;
+	counters.full += back == 0 ? 1 : 0;
+	counters.deltas += back != 0 ? 1 : 0;
+
+	// Older snapshots that arrive late still make good bases
+	auto index = static_cast<std::size_t>(tick) % net::history;
+	if (tick > view_ticks[index]) {
+		std::swap(views[index], decoded);
+		view_ticks[index] = tick;
+		newest = std::max(newest, tick);
+	}
+}
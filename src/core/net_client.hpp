@@ -0,0 +1,85 @@
+#pragma once
+
+#include "bitstream.hpp"
+#include "controller_report.hpp"
+#include "net_view.hpp"
+#include "udp_socket.hpp"
+
+#include <array>
+#include <cinttypes>
+#include <cstddef>
+#include <vector>
+
+// Client end of a dedicated server match. It asks for a slot until the server answers,
+// then sends one input per tick and decodes the snapshots that come back. Every
+// snapshot is a delta against a view the client acknowledged, so the views of the
+// last net::history ticks are kept to decode against.
+class Snapshot_Client {
+  public:
+	struct stats {
+		uint64_t bytes_sent = 0;
+		uint64_t bytes_received = 0;
+		uint64_t snapshots = 0;
+		// Snapshots sent against no base and against an older view
+		uint64_t full = 0;
+		uint64_t deltas = 0;
+		// Malformed, or against a view that is no longer kept
+		uint64_t rejected = 0;
+		// Decoded fine but the checksum didn't match the server's view
+		uint64_t mismatches = 0;
+	};
+
+	explicit Snapshot_Client(const Udp_Socket::address& server, uint32_t match = net::any_match);
+
+	bool is_open() const {
+		return socket.is_open();
+	}
+
+	// Sends this tick's input, or asks for a slot again while there isn't one
+	void send(const control::controller_report& input);
+	// Reads every waiting datagram. True if a view newer than the last one arrived.
+	bool receive();
+
+	bool is_connected() const {
+		return connected;
+	}
+	uint32_t get_match() const {
+		return match;
+	}
+	std::size_t get_slot() const {
+		return slot;
+	}
+	// Seconds per server tick, known once connected
+	float get_step() const {
+		return step;
+	}
+	// Newest view decoded, empty until the first one
+	const net::view& get_view() const {
+		return views[static_cast<std::size_t>(newest) % net::history];
+	}
+	const stats& get_stats() const {
+		return counters;
+	}
+
+  private:
+	void read_snapshot(Bit_Reader& in);
+
+	Udp_Socket socket;
+	Udp_Socket::address server;
+	uint32_t match;
+	bool connected = false;
+	std::size_t slot = 0;
+	float step = 0;
+	// Calls to send since the last hello
+	uint32_t hello_wait = 0;
+
+	// Views by tick modulo net::history and the tick each holds, -1 for none
+	std::array<net::view, net::history> views;
+	std::array<int64_t, net::history> view_ticks;
+	int64_t newest = -1;
+	net::view decoded;
+
+	Bit_Writer packet;
+	std::vector<uint8_t> datagram;
+	stats counters;
+};
@@ -0,0 +1,572 @@
+#include "net_view.hpp"
+#include "game.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+static constexpr std::size_t words_per_chunk = gamegrid::plane_count * gamegrid::chunk_size;
+
+void net::write_varint(Bit_Writer& out, uint32_t value) {
+	while (value >= 0x80) {
+		out.write((value & 0x7F) | 0x80, 8);
+		value >>= 7;
+	}
+	out.write(value, 8);
+}
+
+uint32_t net::read_varint(Bit_Reader& in) {
+	uint32_t value = 0;
+	for (unsigned shift = 0; shift < 35; shift += 7) {
+		auto byte = in.read(8);
+		value |= (byte & 0x7F) << shift;
+		if (!(byte & 0x80)) {
+			return value;
+		}
+	}
+	in.fail();
+	return 0;
+}
+
+static void write_float(Bit_Writer& out, float value) {
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	out.write(bits, 32);
+}
+
+static float read_float(Bit_Reader& in) {
+	uint32_t bits = in.read(32);
+	float value;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+static void write_u64(Bit_Writer& out, uint64_t value) {
+	out.write(static_cast<uint32_t>(value), 32);
+	out.write(static_cast<uint32_t>(value >> 32), 32);
+}
+
+static uint64_t read_u64(Bit_Reader& in) {
+	uint64_t low = in.read(32);
+	return low | (uint64_t(in.read(32)) << 32);
+}
+
+void net::capture(const game::World& world, const view& previous, view& out) {
+	auto&& grid = world.grid;
+	out.tick = world.tick;
+	out.width = static_cast<uint16_t>(grid.width);
+	out.height = static_cast<uint16_t>(grid.height);
+	out.grid.resize(gamegrid::chunk_count(grid) * words_per_chunk);
+	for (std::size_t c = 0; c < gamegrid::chunk_count(grid); ++c) {
+		std::memcpy(out.grid.data() + c * words_per_chunk, grid.chunks[c].planes.data(),
+		            sizeof(gamegrid::Chunk));
+	}
+
+	for (std::size_t i = 0; i < out.players.size(); ++i) {
+		auto p = world.players.get(i);
+		auto&& v = out.players[i];
+		v.loc_x = static_cast<uint16_t>(p.loc_x);
+		v.loc_y = static_cast<uint16_t>(p.loc_y);
+		v.last_x = static_cast<uint16_t>(p.last_x);
+		v.last_y = static_cast<uint16_t>(p.last_y);
+		v.move_start = p.move_start;
+		v.move_end = p.move_end;
+		v.dir = static_cast<uint8_t>(p.dir);
+		v.power = static_cast<uint8_t>(p.power);
+		v.ammo = p.ammo_count;
+		v.active = p.active;
+		v.animated = p.animated;
+		v.kills = world.kills[i];
+		v.deaths = world.deaths[i];
+	}
+
+	// Bullets are stored in the order they were fired, which is id order
+	auto&& bullets = world.bullets;
+	out.bullets.clear();
+	auto known = previous.bullets.begin();
+	for (std::size_t i = 0; i < bullets.size(); ++i) {
+		auto id = bullets.id[i];
+		while (known != previous.bullets.end() && known->id < id) {
+			++known;
+		}
+		if (known != previous.bullets.end() && known->id == id) {
+			out.bullets.push_back(*known);
+			continue;
+		}
+		out.bullets.push_back(net::bullet_view{
+		    id, world.tick, bullets.loc_x[i], bullets.loc_y[i], bullets.vel_x[i],
+		    bullets.vel_y[i], static_cast<uint8_t>(bullets.dir[i]),
+		    static_cast<uint8_t>(bullets.owner[i])});
+	}
+
+	auto&& bombs = world.bombs;
+	out.bombs.clear();
+	for (std::size_t i = 0; i < bombs.size(); ++i) {
+		out.bombs.push_back(net::bomb_view{bombs.id[i], static_cast<uint16_t>(bombs.x[i]),
+		                                   static_cast<uint16_t>(bombs.y[i]),
+		                                   static_cast<uint8_t>(bombs.owner[i]), bombs.live[i],
+		                                   bombs.reach[i]});
+	}
+	std::sort(out.bombs.begin(), out.bombs.end(),
+	          [](auto&& lhs, auto&& rhs) { return lhs.id < rhs.id; });
+}
+
+// Players: a changed bit, then a changed bit per field followed by the field if set
+template <class T, class Write>
+static void write_field(Bit_Writer& out, const T& base, const T& now, Write&& write) {
+	out.write_bool(base != now);
+	if (base != now) {
+		write(now);
+	}
+}
+
+template <class T, class Read>
+static void read_field(Bit_Reader& in, T& value, Read&& read) {
+	if (in.read_bool()) {
+		value = read();
+	}
+}
+
+static bool same_player(const net::player_view& a, const net::player_view& b) {
+	return a.loc_x == b.loc_x && a.loc_y == b.loc_y && a.last_x == b.last_x &&
+	       a.last_y == b.last_y && a.move_start == b.move_start && a.move_end == b.move_end &&
+	       a.dir == b.dir && a.power == b.power && a.ammo == b.ammo && a.active == b.active &&
+	       a.animated == b.animated && a.kills == b.kills && a.deaths == b.deaths;
+}
+
+// Coordinates fit 10 bits, gamegrid::max_size is 1024
+static constexpr unsigned coord_bits = 10;
+
+static void write_player(Bit_Writer& out, uint32_t tick, const net::player_view& base,
+                         const net::player_view& now) {
+	auto coord = [&](uint16_t v) { out.write(v, coord_bits); };
+	write_field(out, base.loc_x, now.loc_x, coord);
+	write_field(out, base.loc_y, now.loc_y, coord);
+	write_field(out, base.last_x, now.last_x, coord);
+	write_field(out, base.last_y, now.last_y, coord);
+	// Moves start at or before the current tick and last a few ticks
+	write_field(out, base.move_start, now.move_start,
+	            [&](uint32_t v) { net::write_varint(out, tick - v); });
+	write_field(out, base.move_end, now.move_end,
+	            [&](uint32_t v) { net::write_varint(out, v - now.move_start); });
+	write_field(out, base.dir, now.dir, [&](uint8_t v) { out.write(v, 2); });
+	write_field(out, base.power, now.power, [&](uint8_t v) { out.write(v, 2); });
+	write_field(out, base.ammo, now.ammo, [&](uint8_t v) { out.write(v, 8); });
+	out.write_bool(now.active);
+	out.write_bool(now.animated);
+	write_field(out, base.kills, now.kills, [&](uint32_t v) { net::write_varint(out, v); });
+	write_field(out, base.deaths, now.deaths, [&](uint32_t v) { net::write_varint(out, v); });
+}
+
+static void read_player(Bit_Reader& in, uint32_t tick, net::player_view& p) {
+	auto coord = [&] { return static_cast<uint16_t>(in.read(coord_bits)); };
+	read_field(in, p.loc_x, coord);
+	read_field(in, p.loc_y, coord);
+	read_field(in, p.last_x, coord);
+	read_field(in, p.last_y, coord);
+	read_field(in, p.move_start, [&] { return tick - net::read_varint(in); });
+	read_field(in, p.move_end, [&] { return p.move_start + net::read_varint(in); });
+	read_field(in, p.dir, [&] { return static_cast<uint8_t>(in.read(2)); });
+	read_field(in, p.power, [&] { return static_cast<uint8_t>(in.read(2)); });
+	read_field(in, p.ammo, [&] { return static_cast<uint8_t>(in.read(8)); });
+	p.active = in.read_bool();
+	p.animated = in.read_bool();
+	read_field(in, p.kills, [&] { return net::read_varint(in); });
+	read_field(in, p.deaths, [&] { return net::read_varint(in); });
+}
+
+// Indices into base of the entities missing from now, both lists in id order
+template <class T>
+static std::vector<uint32_t> removed_indices(const std::vector<T>& base,
+                                             const std::vector<T>& now) {
+	std::vector<uint32_t> removed;
+	auto it = now.begin();
+	for (std::size_t i = 0; i < base.size(); ++i) {
+		while (it != now.end() && it->id < base[i].id) {
+			++it;
+		}
+		if (it == now.end() || it->id != base[i].id) {
+			removed.push_back(static_cast<uint32_t>(i));
+		}
+	}
+	return removed;
+}
+
+static void write_indices(Bit_Writer& out, const std::vector<uint32_t>& indices) {
+	net::write_varint(out, static_cast<uint32_t>(indices.size()));
+	uint32_t next = 0;
+	for (auto i : indices) {
+		net::write_varint(out, i - next);
+		next = i + 1;
+	}
+}
+
+// Marks the listed entries of a list of size count, false if one is out of range
+static bool read_indices(Bit_Reader& in, std::size_t count, std::vector<bool>& marked) {
+	marked.assign(count, false);
+	auto n = net::read_varint(in);
+	uint64_t next = 0;
+	for (uint32_t k = 0; k < n && !in.overflowed(); ++k) {
+		auto index = next + net::read_varint(in);
+		if (index >= count) {
+			return false;
+		}
+		marked[index] = true;
+		next = index + 1;
+	}
+	return !in.overflowed();
+}
+
+static std::size_t popcount64(uint64_t word) {
+	return static_cast<std::size_t>(gamegrid::popcount(word));
+}
+
+void net::write_delta(Bit_Writer& out, const view& base, const view& now) {
+	out.write(now.tick, 32);
+	out.write(now.width, 11);
+	out.write(now.height, 11);
+
+	// Grid: changed words, each as a few flipped bits or the whole word. Picking
+	// something up or a trap appearing flips one bit.
+	bool same_grid = base.grid.size() == now.grid.size();
+	std::vector<uint32_t> changed;
+	for (std::size_t w = 0; w < now.grid.size(); ++w) {
+		if ((same_grid ? base.grid[w] : 0) != now.grid[w]) {
+			changed.push_back(static_cast<uint32_t>(w));
+		}
+	}
+	out.write_bool(same_grid);
+	write_varint(out, static_cast<uint32_t>(changed.size()));
+	uint32_t next = 0;
+	for (auto w : changed) {
+		write_varint(out, w - next);
+		next = w + 1;
+		auto flipped = (same_grid ? base.grid[w] : 0) ^ now.grid[w];
+		auto bits = popcount64(flipped);
+		out.write_bool(bits <= 4);
+		if (bits <= 4) {
+			out.write(static_cast<uint32_t>(bits - 1), 2);
+			for (; flipped != 0; flipped &= flipped - 1) {
+				out.write(static_cast<uint32_t>(gamegrid::lowest_bit(flipped)), 6);
+			}
+		}
+		else {
+			write_u64(out, now.grid[w]);
+		}
+	}
+
+	for (std::size_t i = 0; i < now.players.size(); ++i) {
+		bool player_changed = !same_player(base.players[i], now.players[i]);
+		out.write_bool(player_changed);
+		if (player_changed) {
+			write_player(out, now.tick, base.players[i], now.players[i]);
+		}
+	}
+
+	// Bullets never change once seen, only appear and disappear
+	write_indices(out, removed_indices(base.bullets, now.bullets));
+	std::vector<const bullet_view*> spawned;
+	for (auto&& b : now.bullets) {
+		if (base.bullets.empty() || b.id > base.bullets.back().id) {
+			spawned.push_back(&b);
+		}
+	}
+	write_varint(out, static_cast<uint32_t>(spawned.size()));
+	uint32_t last_id = base.bullets.empty() ? 0 : base.bullets.back().id;
+	for (auto b : spawned) {
+		write_varint(out, b->id - last_id);
+		last_id = b->id;
+		write_varint(out, now.tick - b->spawn_tick);
+		write_float(out, b->x);
+		write_float(out, b->y);
+		write_float(out, b->vel_x);
+		write_float(out, b->vel_y);
+		out.write(b->dir, 2);
+		out.write(b->owner, 8);
+	}
+
+	// Bombs also change once, when they go off
+	write_indices(out, removed_indices(base.bombs, now.bombs));
+	std::vector<uint32_t> exploded;
+	std::vector<const bomb_view*> placed;
+	auto it = base.bombs.begin();
+	for (auto&& b : now.bombs) {
+		while (it != base.bombs.end() && it->id < b.id) {
+			++it;
+		}
+		if (it != base.bombs.end() && it->id == b.id) {
+			if (it->live != b.live || it->reach != b.reach) {
+				exploded.push_back(static_cast<uint32_t>(it - base.bombs.begin()));
+			}
+		}
+		else {
+			placed.push_back(&b);
+		}
+	}
+	auto write_state = [&](const bomb_view& b) {
+		out.write_bool(b.live);
+		for (auto r : b.reach) {
+			out.write(r, 2);
+		}
+	};
+	write_indices(out, exploded);
+	for (auto index : exploded) {
+		auto&& b = base.bombs[index];
+		write_state(*std::lower_bound(now.bombs.begin(), now.bombs.end(), b.id,
+		                              [](auto&& e, uint32_t id) { return e.id < id; }));
+	}
+	write_varint(out, static_cast<uint32_t>(placed.size()));
+	last_id = 0;
+	for (auto b : placed) {
+		write_varint(out, b->id - last_id);
+		last_id = b->id;
+		out.write(b->x, coord_bits);
+		out.write(b->y, coord_bits);
+		out.write(b->owner, 8);
+		write_state(*b);
+	}
+}
+
+bool net::read_delta(Bit_Reader& in, const view& base, view& out) {
+	out.tick = in.read(32);
+	out.width = static_cast<uint16_t>(in.read(11));
+	out.height = static_cast<uint16_t>(in.read(11));
+	if (out.width == 0 || out.height == 0 || out.width > gamegrid::max_size ||
+	    out.height > gamegrid::max_size) {
+		return false;
+	}
+
+	auto chunks_x = (out.width + gamegrid::chunk_size - 1) / gamegrid::chunk_size;
+	auto chunks_y = (out.height + gamegrid::chunk_size - 1) / gamegrid::chunk_size;
+	auto words = chunks_x * chunks_y * words_per_chunk;
+	bool same_grid = in.read_bool();
+	if (same_grid && base.grid.size() != words) {
+		return false;
+	}
+	if (same_grid) {
+		out.grid = base.grid;
+	}
+	else {
+		out.grid.assign(words, 0);
+	}
+	auto changed = read_varint(in);
+	uint64_t next = 0;
+	for (uint32_t k = 0; k < changed && !in.overflowed(); ++k) {
+		auto w = next + read_varint(in);
+		if (w >= words) {
+			return false;
+		}
+		next = w + 1;
+		if (in.read_bool()) {
+			auto bits = in.read(2) + 1;
+			for (uint32_t b = 0; b < bits; ++b) {
+				out.grid[w] ^= uint64_t(1) << in.read(6);
+			}
+		}
+		else {
+			out.grid[w] = read_u64(in);
+		}
+	}
+
+	out.players = base.players;
+	for (auto&& p : out.players) {
+		if (in.read_bool()) {
+			read_player(in, out.tick, p);
+		}
+	}
+
+	std::vector<bool> removed;
+	if (!read_indices(in, base.bullets.size(), removed)) {
+		return false;
+	}
+	out.bullets.clear();
+	for (std::size_t i = 0; i < base.bullets.size(); ++i) {
+		if (!removed[i]) {
+			out.bullets.push_back(base.bullets[i]);
+		}
+	}
+	auto spawned = read_varint(in);
+	uint32_t last_id = base.bullets.empty() ? 0 : base.bullets.back().id;
+	for (uint32_t k = 0; k < spawned && !in.overflowed(); ++k) {
+		bullet_view b;
+		b.id = last_id + read_varint(in);
+		last_id = b.id;
+		b.spawn_tick = out.tick - read_varint(in);
+		b.x = read_float(in);
+		b.y = read_float(in);
+		b.vel_x = read_float(in);
+		b.vel_y = read_float(in);
+		b.dir = static_cast<uint8_t>(in.read(2));
+		b.owner = static_cast<uint8_t>(in.read(8));
+		out.bullets.push_back(b);
+	}
+
+	if (!read_indices(in, base.bombs.size(), removed)) {
+		return false;
+	}
+	std::vector<bool> exploded;
+	if (!read_indices(in, base.bombs.size(), exploded)) {
+		return false;
+	}
+	auto read_state = [&](bomb_view& b) {
+		b.live = in.read_bool();
+		for (auto&& r : b.reach) {
+			r = static_cast<uint8_t>(in.read(2));
+		}
+	};
+	out.bombs.clear();
+	for (std::size_t i = 0; i < base.bombs.size(); ++i) {
+		auto b = base.bombs[i];
+		if (exploded[i]) {
+			read_state(b);
+		}
+		if (!removed[i]) {
+			out.bombs.push_back(b);
+		}
+	}
+	auto placed = read_varint(in);
+	last_id = 0;
+	for (uint32_t k = 0; k < placed && !in.overflowed(); ++k) {
+		bomb_view b;
+		b.id = last_id + read_varint(in);
+		last_id = b.id;
+		b.x = static_cast<uint16_t>(in.read(coord_bits));
+		b.y = static_cast<uint16_t>(in.read(coord_bits));
+		b.owner = static_cast<uint8_t>(in.read(8));
+		read_state(b);
+		out.bombs.push_back(b);
+	}
+	std::sort(out.bombs.begin(), out.bombs.end(),
+	          [](auto&& lhs, auto&& rhs) { return lhs.id < rhs.id; });
+
+	return !in.overflowed();
+}
+
+uint32_t net::checksum(const view& v) {
+	// FNV-1a over the fields, padding never goes in
+	uint32_t hash = 2166136261u;
+	auto mix = [&](uint64_t value, unsigned bytes) {
+		for (unsigned b = 0; b < bytes; ++b) {
+			hash = (hash ^ static_cast<uint8_t>(value >> (8 * b))) * 16777619u;
+		}
+	};
+	auto mix_float = [&](float value) {
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		mix(bits, 4);
+	};
+
+	mix(v.tick, 4);
+	mix(v.width, 2);
+	mix(v.height, 2);
+	for (auto w : v.grid) {
+		mix(w, 8);
+	}
+	for (auto&& p : v.players) {
+		mix(p.loc_x, 2);
+		mix(p.loc_y, 2);
+		mix(p.last_x, 2);
+		mix(p.last_y, 2);
+		mix(p.move_start, 4);
+		mix(p.move_end, 4);
+		mix(p.dir, 1);
+		mix(p.power, 1);
+		mix(p.ammo, 1);
+		mix(p.active, 1);
+		mix(p.animated, 1);
+		mix(p.kills, 4);
+		mix(p.deaths, 4);
+	}
+	for (auto&& b : v.bullets) {
+		mix(b.id, 4);
+		mix(b.spawn_tick, 4);
+		mix_float(b.x);
+		mix_float(b.y);
+		mix_float(b.vel_x);
+		mix_float(b.vel_y);
+		mix(b.dir, 1);
+		mix(b.owner, 1);
+	}
+	for (auto&& b : v.bombs) {
+		mix(b.id, 4);
+		mix(b.x, 2);
+		mix(b.y, 2);
+		mix(b.owner, 1);
+		mix(b.live, 1);
+		for (auto r : b.reach) {
+			mix(r, 1);
+		}
+	}
+	return hash;
+}
+
+void net::apply(const view& v, float step, game::World& world) {
+	auto&& grid = world.grid;
+	grid.width = v.width;
+	grid.height = v.height;
+	grid.chunks_x = (grid.width + gamegrid::chunk_size - 1) / gamegrid::chunk_size;
+	grid.chunks_y = (grid.height + gamegrid::chunk_size - 1) / gamegrid::chunk_size;
+	grid.revision += 1;
+	auto chunks = std::min(gamegrid::chunk_count(grid), v.grid.size() / words_per_chunk);
+	for (std::size_t c = 0; c < chunks; ++c) {
+		std::memcpy(grid.chunks[c].planes.data(), v.grid.data() + c * words_per_chunk,
+		            sizeof(gamegrid::Chunk));
+	}
+	world.tick = v.tick;
+	world.step = step;
+
+	for (std::size_t i = 0; i < v.players.size(); ++i) {
+		auto p = world.players.get(i);
+		auto&& pv = v.players[i];
+		auto previous = players::location(p);
+		p.loc_x = pv.loc_x;
+		p.loc_y = pv.loc_y;
+		p.last_x = pv.last_x;
+		p.last_y = pv.last_y;
+		p.move_start = pv.move_start;
+		p.move_end = pv.move_end;
+		p.dir = static_cast<players::player_info::direction>(pv.dir);
+		p.power = static_cast<players::player_info::powerup>(pv.power);
+		p.ammo_count = pv.ammo;
+		p.active = pv.active;
+		p.animated = pv.animated;
+		p.factor = 1.0f;
+		if (pv.animated && pv.move_end > pv.move_start) {
+			p.factor = std::min(1.0f, static_cast<float>(v.tick - pv.move_start) /
+			                              static_cast<float>(pv.move_end - pv.move_start));
+		}
+		p.prev_x = previous.x;
+		p.prev_y = previous.y;
+		world.players.set(i, p);
+		world.kills[i] = pv.kills;
+		world.deaths[i] = pv.deaths;
+	}
+
+	world.bullets.clear();
+	for (auto&& b : v.bullets) {
+		auto flown = static_cast<float>(v.tick - b.spawn_tick) * step;
+		bullet::bullet_data bd;
+		bd.loc_x = b.x + b.vel_x * flown;
+		bd.loc_y = b.y + b.vel_y * flown;
+		bd.prev_x = v.tick > b.spawn_tick ? bd.loc_x - b.vel_x * step : bd.loc_x;
+		bd.prev_y = v.tick > b.spawn_tick ? bd.loc_y - b.vel_y * step : bd.loc_y;
+		bd.vel_x = b.vel_x;
+		bd.vel_y = b.vel_y;
+		bd.dir = static_cast<bullet::bullet_data::direction>(b.dir);
+		bd.lifespan = 1.0f;
+		bd.owner = b.owner;
+		bd.id = b.id;
+		world.bullets.push_back(bd);
+	}
+
+	world.bombs.clear();
+	for (auto&& b : v.bombs) {
+		bomb::bomb_data bd;
+		bd.x = b.x;
+		bd.y = b.y;
+		bd.owner = b.owner;
+		bd.id = b.id;
+		bd.live = b.live;
+		bd.reach = b.reach;
+		world.bombs.push_back(bd);
+	}
+}
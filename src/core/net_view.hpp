@@ -0,0 +1,92 @@
+#pragma once
+
+#include "bitstream.hpp"
+#include "controller_report.hpp"
+
+#include <array>
+#include <cinttypes>
+#include <cstddef>
+#include <vector>
+
+namespace game {
+	struct World;
+}
+
+// What a client of a dedicated server is told about a match, and the coding of one
+// view as changes from an older one the client has acknowledged. Bullets fly in a
+// straight line, so they are only sent when they appear and disappear. Players are
+// sent when something about them changes, their position in between follows from the
+// ticks their move started and ends on.
+namespace net {
+	struct player_view {
+		uint16_t loc_x = 0, loc_y = 0;
+		uint16_t last_x = 0, last_y = 0;
+		uint32_t move_start = 0, move_end = 0;
+		uint8_t dir = 0;
+		uint8_t power = 0;
+		uint8_t ammo = 0;
+		bool active = false;
+		bool animated = false;
+		uint32_t kills = 0, deaths = 0;
+	};
+
+	struct bullet_view {
+		uint32_t id;
+		// Where it was at the end of the tick it was first seen
+		uint32_t spawn_tick;
+		float x, y;
+		float vel_x, vel_y;
+		uint8_t dir;
+		uint8_t owner;
+	};
+
+	struct bomb_view {
+		uint32_t id;
+		uint16_t x, y;
+		uint8_t owner;
+		bool live;
+		std::array<uint8_t, 4> reach;
+	};
+
+	struct view {
+		uint32_t tick = 0;
+		uint16_t width = 0, height = 0;
+		// Every bit plane of every used chunk, in chunk order
+		std::vector<uint64_t> grid;
+		std::array<player_view, control::max_players> players;
+		// Both in id order
+		std::vector<bullet_view> bullets;
+		std::vector<bomb_view> bombs;
+	};
+
+	// Datagram kinds, the first message_bits bits of every datagram.
+	//   hello     client -> server  match wanted (16)
+	//   input     client -> server  newest tick received (32), packed report (24)
+	//   welcome   server -> client  match (16), slot (8), seconds per tick (32)
+	//   snapshot  server -> client  ticks back to the base (6, 0 for none), checksum of
+	//                               the view (32), delta
+	enum class message : uint32_t { hello = 0, input = 1, welcome = 2, snapshot = 3 };
+	constexpr unsigned message_bits = 2;
+	constexpr uint32_t any_match = 0xFFFF;
+	// Largest UDP payload. A full view of an arena past about 320x320 doesn't fit.
+	constexpr std::size_t max_datagram = 65507;
+	// Views both ends keep to delta against, a base further back than this isn't used
+	constexpr uint32_t history = 32;
+
+	// Builds the view of a world. Bullets that are already in previous keep their
+	// spawn record, new ones are recorded where they are now.
+	void capture(const game::World& world, const view& previous, view& out);
+	// Writes now, tick included, as changes from base. An empty base gives a full view.
+	void write_delta(Bit_Writer& out, const view& base, const view& now);
+	// False if the data doesn't decode against base
+	bool read_delta(Bit_Reader& in, const view& base, view& out);
+	uint32_t checksum(const view& v);
+
+	// Fills a world from a view so the renderer can draw it. step is the length of the
+	// server's tick in seconds.
+	void apply(const view& v, float step, game::World& world);
+
+	// 7 bits at a time, low bits first, for counts and gaps that are usually small
+	void write_varint(Bit_Writer& out, uint32_t value);
+	uint32_t read_varint(Bit_Reader& in);
+}
@@ -0,0 +1,315 @@
+#include "player.hpp"
+#include "spatial_index.hpp"
+#include "bomb.hpp"
+#include "bullet.hpp"
+#include "game.hpp"
+#include "gamegrid.hpp"
+#include <algorithm>
+#include <array>
+
+void players::initialize(game::World& world) {
+	for (std::size_t i = 0; i < world.players.size(); ++i) {
+		world.players.set(i, player_info{});
+		respawn(world, i);
+	}
+}
+
+void players::update_players(game::World& world, const control::movement_report_type& report) {
+	auto&& grid = world.grid;
+	auto&& ps = world.players;
+
+	for (std::size_t i = 0; i < ps.size(); ++i) {
+		auto&& controller = report[i];
+
+		// Slots nobody plays are put back on their spawn once and then left alone
+		if (!controller.active) {
+			if (ps.active[i]) {
+				ps.active[i] = false;
+				respawn(world, i);
+			}
+			continue;
+		}
+		ps.active[i] = true;
+
+		auto previous = location(ps, i);
+		ps.prev_x[i] = previous.x;
+		ps.prev_y[i] = previous.y;
+
+		if (ps.animated[i]) {
+			if (world.tick < ps.move_end[i]) {
+				ps.factor[i] = static_cast<float>(world.tick - ps.move_start[i]) /
+				               static_cast<float>(ps.move_end[i] - ps.move_start[i]);
+			}
+			else {
+				ps.factor[i] = 1.0f;
+				ps.animated[i] = false;
+			}
+		}
+		else {
+			switch (gamegrid::get(grid, ps.loc_x[i], ps.loc_y[i])) {
+				case gamegrid::StateType::powerup_ammo: {
+					ps.ammo_count[i] = static_cast<uint8_t>(ps.ammo_count[i] + 2);
+					gamegrid::set(grid, ps.loc_x[i], ps.loc_y[i], gamegrid::StateType::empty);
+					break;
+				}
+				case gamegrid::StateType::powerup_bomb:
+					if (ps.power[i] != player_info::powerup::bomb) {
+						ps.power[i] = player_info::powerup::bomb;
+						gamegrid::set(grid, ps.loc_x[i], ps.loc_y[i], gamegrid::StateType::empty);
+					}
+					break;
+				case gamegrid::StateType::trap:
+					kill(world, i, no_player);
+					break;
+				default:
+					break;
+			}
+
+			if (controller.left_stick_dir != control::controller_report::direction::none) {
+				ps.factor[i] = 0.0f;
+				ps.animated[i] = true;
+				ps.move_start[i] = world.tick;
+				ps.move_end[i] = game::ticks_from_now(world, move_duration);
+				ps.last_x[i] = ps.loc_x[i];
+				ps.last_y[i] = ps.loc_y[i];
+			}
+			switch (controller.left_stick_dir) {
+				case control::controller_report::direction::left:
+					if (ps.loc_x[i] > 0) {
+						ps.dir[i] = player_info::direction::left;
+						ps.loc_x[i] -= 1;
+					}
+					break;
+				case control::controller_report::direction::right:
+					if (ps.loc_x[i] < grid.width - 1) {
+						ps.dir[i] = player_info::direction::right;
+						ps.loc_x[i] += 1;
+					}
+					break;
+				case control::controller_report::direction::up:
+					if (ps.loc_y[i] > 0) {
+						ps.dir[i] = player_info::direction::up;
+						ps.loc_y[i] -= 1;
+					}
+					break;
+				case control::controller_report::direction::down:
+					if (ps.loc_y[i] < grid.height - 1) {
+						ps.dir[i] = player_info::direction::down;
+						ps.loc_y[i] += 1;
+					}
+					break;
+
+				default:
+					break;
+			}
+		}
+
+		// Ammo, powerups and cooldowns are only used up once the bullet or bomb exists, a
+		// full store leaves the player to try again next tick
+		if (controller.rtrigger && world.tick >= ps.bullet_ready[i] && ps.ammo_count[i] >= 1) {
+			auto grid_loc = location(ps, i);
+			grid_location velocity{0.0f, 0.0f};
+
+			constexpr float bullet_speed = 15.0f;
+			switch (ps.dir[i]) {
+				case player_info::direction::left:
+					velocity = grid_location{-bullet_speed, 0.0f};
+					break;
+				case player_info::direction::right:
+					velocity = grid_location{bullet_speed, 0.0f};
+					break;
+				case player_info::direction::up:
+					velocity = grid_location{0.0f, -bullet_speed};
+					break;
+				case player_info::direction::down:
+					velocity = grid_location{0.0f, bullet_speed};
+					break;
+				default:
+					break;
+			}
+
+			auto shot =
+			    bullet::add_bullet(world, i, grid_loc.x, grid_loc.y, velocity.x, velocity.y, 10.0f);
+			if (shot.slot != no_entity.slot) {
+				ps.bullet_ready[i] = game::ticks_from_now(world, bullet_cooldown);
+				ps.ammo_count[i] = static_cast<uint8_t>(ps.ammo_count[i] - 1);
+			}
+		}
+		if (controller.ltrigger && world.tick >= ps.bomb_ready[i] &&
+		    ps.power[i] == player_info::powerup::bomb) {
+			auto placed = bomb::add_bomb(world, i, ps.loc_x[i], ps.loc_y[i], 1.5f);
+			if (placed.slot != no_entity.slot) {
+				ps.bomb_ready[i] = game::ticks_from_now(world, bomb_cooldown);
+				ps.power[i] = player_info::powerup::none;
+			}
+		}
+	}
+}
+
+// Edge cells are numbered clockwise from the top left corner. A grid one cell thin is
+// edge all the way through.
+static std::size_t edge_cells(std::size_t width, std::size_t height) {
+	if (width < 2 || height < 2) {
+		return width * height;
+	}
+	return 2 * (width - 1) + 2 * (height - 1);
+}
+
+static void edge_cell(std::size_t width, std::size_t height, std::size_t p, std::size_t& x,
+                      std::size_t& y, players::player_info::direction& dir) {
+	using direction = players::player_info::direction;
+	if (height < 2) {
+		x = p;
+		y = 0;
+		dir = direction::right;
+	}
+	else if (width < 2) {
+		x = 0;
+		y = p;
+		dir = direction::down;
+	}
+	else if (p < width - 1) {
+		x = p;
+		y = 0;
+		dir = direction::right;
+	}
+	else if ((p -= width - 1) < height - 1) {
+		x = width - 1;
+		y = p;
+		dir = direction::down;
+	}
+	else if ((p -= height - 1) < width - 1) {
+		x = width - 1 - p;
+		y = height - 1;
+		dir = direction::left;
+	}
+	else {
+		p -= width - 1;
+		x = 0;
+		y = height - 1 - p;
+		dir = direction::up;
+	}
+}
+
+// Each corner starts an edge, clockwise. The k-th slot on an edge goes k bits reversed of
+// the way along it (0, 1/2, 1/4, 3/4, 1/8...), so however many players there are they
+// end up about evenly spread.
+static std::size_t spread_position(std::size_t width, std::size_t height, std::size_t slot) {
+	auto k = static_cast<uint32_t>(slot / 4);
+	uint32_t fraction = 0;
+	for (uint32_t bit = 0; bit < 16; ++bit) {
+		if ((k >> bit) & 1) {
+			fraction |= 1u << (15 - bit);
+		}
+	}
+	auto along = [&](std::size_t length) {
+		return static_cast<std::size_t>((uint64_t(fraction) * length + (1u << 15)) >> 16);
+	};
+
+	auto across = width > 0 ? width - 1 : 0;
+	auto down = height > 0 ? height - 1 : 0;
+	std::array<std::size_t, 4> start = {{0, across, across + down, 2 * across + down}};
+	auto length = slot % 2 == 0 ? across : down;
+	return (start[slot % 4] + along(length)) % std::max<std::size_t>(edge_cells(width, height), 1);
+}
+
+void players::spawn_point(std::size_t width, std::size_t height, std::size_t slot,
+                          std::size_t& x, std::size_t& y, player_info::direction& dir) {
+	// Rounding to cells puts several slots on one cell on small grids. A slot landing on
+	// an earlier slot's cell moves on clockwise to the next free one, until every edge
+	// cell is taken and the rest have to share.
+	auto cells = edge_cells(width, height);
+	std::array<std::size_t, control::max_players> taken;
+	std::size_t p = 0;
+	for (std::size_t s = 0; s <= slot; ++s) {
+		p = spread_position(width, height, s);
+		auto end = taken.begin() + static_cast<std::ptrdiff_t>(s);
+		while (s < cells && std::find(taken.begin(), end, p) != end) {
+			p = (p + 1) % cells;
+		}
+		taken[s] = p;
+	}
+	edge_cell(width, height, p, x, y, dir);
+}
+
+void players::respawn(game::World& world, std::size_t player_index) {
+	auto&& grid = world.grid;
+	auto&& ps = world.players;
+	auto i = player_index;
+
+	spawn_point(grid.width, grid.height, i, ps.loc_x[i], ps.loc_y[i], ps.dir[i]);
+	ps.factor[i] = 1.0f;
+	ps.animated[i] = false;
+	ps.last_x[i] = 0;
+	ps.last_y[i] = 0;
+	ps.prev_x[i] = static_cast<float>(ps.loc_x[i]);
+	ps.prev_y[i] = static_cast<float>(ps.loc_y[i]);
+	ps.ammo_count[i] = 1;
+	ps.power[i] = player_info::powerup::none;
+
+	spatial::update_player(world, player_index);
+}
+
+void players::kill(game::World& world, std::size_t player_index, std::size_t killer_index) {
+	world.deaths[player_index] += 1;
+	if (killer_index != no_player && killer_index != player_index) {
+		world.kills[killer_index] += 1;
+	}
+
+	respawn(world, player_index);
+}
+
+players::grid_location players::location(const player_store& players, std::size_t slot) {
+	auto last_x = static_cast<float>(players.last_x[slot]);
+	auto last_y = static_cast<float>(players.last_y[slot]);
+	auto factor = players.factor[slot];
+	return grid_location{last_x + (static_cast<float>(players.loc_x[slot]) - last_x) * factor,
+	                     last_y + (static_cast<float>(players.loc_y[slot]) - last_y) * factor};
+}
+
+players::player_info players::player_store::get(std::size_t slot) const {
+	player_info p;
+	p.loc_x = loc_x[slot];
+	p.loc_y = loc_y[slot];
+	p.last_x = last_x[slot];
+	p.last_y = last_y[slot];
+	p.factor = factor[slot];
+	p.move_start = move_start[slot];
+	p.move_end = move_end[slot];
+	p.prev_x = prev_x[slot];
+	p.prev_y = prev_y[slot];
+	p.dir = dir[slot];
+	p.animated = animated[slot];
+	p.active = active[slot];
+	p.power = power[slot];
+	p.ammo_count = ammo_count[slot];
+	p.bullet_ready = bullet_ready[slot];
+	p.bomb_ready = bomb_ready[slot];
+	return p;
+}
+
+void players::player_store::set(std::size_t slot, const player_info& p) {
+	loc_x[slot] = p.loc_x;
+	loc_y[slot] = p.loc_y;
+	last_x[slot] = p.last_x;
+	last_y[slot] = p.last_y;
+	factor[slot] = p.factor;
+	move_start[slot] = p.move_start;
+	move_end[slot] = p.move_end;
+	prev_x[slot] = p.prev_x;
+	prev_y[slot] = p.prev_y;
+	dir[slot] = p.dir;
+	animated[slot] = p.animated;
+	active[slot] = p.active;
+	power[slot] = p.power;
+	ammo_count[slot] = p.ammo_count;
+	bullet_ready[slot] = p.bullet_ready;
+	bomb_ready[slot] = p.bomb_ready;
+}
+
+players::grid_location players::location(const player_info& player) {
+	auto last_x = static_cast<float>(player.last_x);
+	auto last_y = static_cast<float>(player.last_y);
+	return grid_location{last_x + (static_cast<float>(player.loc_x) - last_x) * player.factor,
+	                     last_y + (static_cast<float>(player.loc_y) - last_y) * player.factor};
+}
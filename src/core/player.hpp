@@ -0,0 +1,82 @@
+#pragma once
+
+#include "controller_report.hpp"
+#include <array>
+#include <cinttypes>
+#include <cstddef>
+#include <limits>
+
+namespace game {
+	struct World;
+}
+
+namespace players {
+	struct player_info {
+		enum class direction : uint8_t { up = 0, left = 1, down = 2, right = 3 };
+		std::size_t loc_x, loc_y;
+		std::size_t last_x, last_y;
+		float factor = 1.0;
+		// Ticks the current move started and ends on
+		uint32_t move_start = 0, move_end = 0;
+		// Location at the end of the previous tick, used to interpolate rendering
+		float prev_x = 0, prev_y = 0;
+		direction dir;
+		bool animated = false;
+		bool active = false;
+		enum class powerup : uint8_t { none = 0, trap, bomb };
+		powerup power = powerup::none;
+		uint8_t ammo_count = 1;
+		// First tick the player may fire or drop a bomb again
+		uint32_t bullet_ready = 0;
+		uint32_t bomb_ready = 0;
+	};
+
+	// Player archetype, one entry per slot whether anyone plays it or not. Index i in
+	// every column is slot i, player_info is one row of it.
+	struct player_store {
+		template <class T>
+		using column = std::array<T, control::max_players>;
+
+		column<std::size_t> loc_x, loc_y;
+		column<std::size_t> last_x, last_y;
+		column<float> factor;
+		column<uint32_t> move_start, move_end;
+		column<float> prev_x, prev_y;
+		column<player_info::direction> dir;
+		column<bool> animated;
+		column<bool> active;
+		column<player_info::powerup> power;
+		column<uint8_t> ammo_count;
+		column<uint32_t> bullet_ready, bomb_ready;
+
+		static constexpr std::size_t size() {
+			return control::max_players;
+		}
+		player_info get(std::size_t slot) const;
+		void set(std::size_t slot, const player_info& player);
+	};
+
+	struct grid_location {
+		float x, y;
+	};
+
+	// Seconds a move between cells takes, and the time between shots and bombs
+	constexpr float move_duration = 0.25f;
+	constexpr float bullet_cooldown = 0.5f;
+	constexpr float bomb_cooldown = 2.0f;
+
+	// Killer index for deaths that aren't caused by another player
+	constexpr std::size_t no_player = std::numeric_limits<std::size_t>::max();
+
+	void initialize(game::World& world);
+	void update_players(game::World& world, const control::movement_report_type&);
+	// Cell a slot starts on and the way it faces there. The first four slots take the
+	// corners, later ones are spread out along the edges, which are always clear. No two
+	// of the first slots share a cell while the edges have room for them all.
+	void spawn_point(std::size_t width, std::size_t height, std::size_t slot, std::size_t& x,
+	                 std::size_t& y, player_info::direction& dir);
+	void respawn(game::World& world, std::size_t player_index);
+	void kill(game::World& world, std::size_t player_index, std::size_t killer_index);
+	grid_location location(const player_info& player);
+	grid_location location(const player_store& players, std::size_t slot);
+}
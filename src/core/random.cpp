@@ -0,0 +1,28 @@
+#include "random.hpp"
+
+void Random::seed(uint64_t value, uint64_t stream) {
+	state = 0;
+	increment = (stream << 1) | 1;
+	next();
+	state += value;
+	next();
+}
+
+uint32_t Random::next() {
+	uint64_t old = state;
+	state = old * 6364136223846793005ull + increment;
+	auto xorshifted = static_cast<uint32_t>(((old >> 18) ^ old) >> 27);
+	auto rot = static_cast<uint32_t>(old >> 59);
+	return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+}
+
+uint32_t Random::below(uint32_t bound) {
+	// Reject the top part of the range that doesn't divide evenly by bound
+	uint32_t threshold = (0u - bound) % bound;
+	while (true) {
+		uint32_t r = next();
+		if (r >= threshold) {
+			return r % bound;
+		}
+	}
+}
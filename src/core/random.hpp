@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cinttypes>
+
+// PCG32 random number generator. The algorithm is fixed, unlike std::mt19937 with
+// the standard distributions, so a seed produces the same match with every compiler
+// and standard library. Replays and network peers depend on that. It is also two
+// words of plain data, so it is saved and restored with the rest of the world.
+struct Random {
+	uint64_t state = 0;
+	uint64_t increment = 1;
+
+	void seed(uint64_t value, uint64_t stream = 0xDA3E39CB94B95BDBull);
+	uint32_t next();
+	// Uniform in [0, bound) without modulo bias
+	uint32_t below(uint32_t bound);
+};
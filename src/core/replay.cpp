@@ -0,0 +1,465 @@
+#include "replay.hpp"
+#include "game.hpp"
+#include <algorithm>
+#include <istream>
+#include <ostream>
+
+// The same field list is used to save and to load, through one of these streams.
+// Values are stored as their raw bytes, so only padding free types go through bytes().
+// Members that are stored differently from how they are kept check loading.
+struct save_stream {
+	static constexpr bool loading = false;
+	Bit_Writer& out;
+
+	template <class T>
+	void value(const T& v) {
+		out.write_bytes(&v, sizeof(v));
+	}
+	void bytes(const void* data, std::size_t size) {
+		out.write_bytes(data, size);
+	}
+	// Writes the count, always within the capacity when saving
+	void count(uint32_t& n, std::size_t) {
+		value(n);
+	}
+	void fail() {
+	}
+};
+
+struct load_stream {
+	static constexpr bool loading = true;
+	Bit_Reader& in;
+
+	template <class T>
+	void value(T& v) {
+		in.read_bytes(&v, sizeof(v));
+	}
+	void bytes(void* data, std::size_t size) {
+		in.read_bytes(data, size);
+	}
+	// Counts are checked against the capacity they index into, so a damaged file
+	// can't write past the end of a container
+	void count(uint32_t& n, std::size_t capacity) {
+		value(n);
+		if (n > capacity) {
+			fail();
+		}
+	}
+	void fail() {
+		in.fail();
+	}
+};
+
+template <class Stream, class T, std::size_t N>
+static void transfer_column(Stream& s, std::array<T, N>& column, std::size_t count) {
+	s.bytes(column.data(), count * sizeof(T));
+}
+
+template <class Stream>
+static void transfer_world(Stream& s, game::World& world, std::size_t slots) {
+	auto&& grid = world.grid;
+	s.value(grid.width);
+	s.value(grid.height);
+	s.value(grid.chunks_x);
+	s.value(grid.chunks_y);
+	s.value(grid.revision);
+	auto chunks = static_cast<uint32_t>(gamegrid::chunk_count(grid));
+	s.count(chunks, gamegrid::max_chunks);
+	if (chunks != gamegrid::chunk_count(grid) || chunks > gamegrid::max_chunks ||
+	    grid.width > gamegrid::max_size || grid.height > gamegrid::max_size ||
+	    grid.chunks_x * gamegrid::chunk_size < grid.width ||
+	    grid.chunks_y * gamegrid::chunk_size < grid.height) {
+		s.fail();
+		return;
+	}
+	s.bytes(grid.chunks.data(), chunks * sizeof(gamegrid::Chunk));
+
+	auto&& ps = world.players;
+	transfer_column(s, ps.loc_x, slots);
+	transfer_column(s, ps.loc_y, slots);
+	transfer_column(s, ps.last_x, slots);
+	transfer_column(s, ps.last_y, slots);
+	transfer_column(s, ps.factor, slots);
+	transfer_column(s, ps.move_start, slots);
+	transfer_column(s, ps.move_end, slots);
+	transfer_column(s, ps.prev_x, slots);
+	transfer_column(s, ps.prev_y, slots);
+	transfer_column(s, ps.dir, slots);
+	transfer_column(s, ps.animated, slots);
+	transfer_column(s, ps.active, slots);
+	transfer_column(s, ps.power, slots);
+	transfer_column(s, ps.ammo_count, slots);
+	transfer_column(s, ps.bullet_ready, slots);
+	transfer_column(s, ps.bomb_ready, slots);
+
+	auto&& bullets = world.bullets;
+	bullets.entities.transfer(s);
+	auto count = bullets.size();
+	transfer_column(s, bullets.loc_x, count);
+	transfer_column(s, bullets.loc_y, count);
+	transfer_column(s, bullets.prev_x, count);
+	transfer_column(s, bullets.prev_y, count);
+	transfer_column(s, bullets.vel_x, count);
+	transfer_column(s, bullets.vel_y, count);
+	transfer_column(s, bullets.lifespan, count);
+	transfer_column(s, bullets.dir, count);
+	transfer_column(s, bullets.owner, count);
+	transfer_column(s, bullets.id, count);
+	transfer_column(s, bullets.cell, count);
+
+	auto&& bombs = world.bombs;
+	bombs.entities.transfer(s);
+	count = bombs.size();
+	transfer_column(s, bombs.x, count);
+	transfer_column(s, bombs.y, count);
+	transfer_column(s, bombs.timer, count);
+	transfer_column(s, bombs.owner, count);
+	transfer_column(s, bombs.id, count);
+	transfer_column(s, bombs.live, count);
+	transfer_column(s, bombs.reach, count);
+
+	world.timers.transfer(s);
+	s.value(world.tick);
+	s.value(world.step);
+	s.value(world.prng.state);
+	s.value(world.prng.increment);
+	s.value(world.next_id);
+	transfer_column(s, world.kills, slots);
+	transfer_column(s, world.deaths, slots);
+}
+
+void replay::save_world(const game::World& world, Bit_Writer& out, std::size_t played) {
+	save_stream stream{out};
+	// Saving only reads, the field list is shared with loading so it takes non-const
+	transfer_world(stream, const_cast<game::World&>(world), played);
+}
+
+bool replay::load_world(game::World& world, Bit_Reader& in, std::size_t played) {
+	if (played > control::max_players) {
+		return false;
+	}
+	load_stream stream{in};
+	transfer_world(stream, world, played);
+
+	// Slots nobody played are still where game::initialize put them
+	for (auto slot = played; slot < world.players.size(); ++slot) {
+		world.players.set(slot, players::player_info{});
+		players::respawn(world, slot);
+		world.kills[slot] = 0;
+		world.deaths[slot] = 0;
+	}
+
+	world.index = spatial::SpatialIndex{};
+	world.blast = bomb::blast_state{};
+	world.fired.clear();
+
+	return !in.overflowed();
+}
+
+uint64_t replay::checksum(const game::World& world) {
+	Bit_Writer out;
+	save_world(world, out);
+
+	uint64_t hash = 14695981039346656037ull;
+	for (auto byte : out.finish()) {
+		hash = (hash ^ byte) * 1099511628211ull;
+	}
+	return hash;
+}
+
+uint32_t replay::pack_report(const control::controller_report& report) {
+	uint32_t packed = static_cast<uint32_t>(report.left_stick_dir);
+	packed |= static_cast<uint32_t>(report.right_stick_dir) << 3;
+	packed |= uint32_t(report.active) << 6;
+	packed |= uint32_t(report.ltrigger) << 7;
+	packed |= uint32_t(report.rtrigger) << 8;
+	for (std::size_t k = 0; k < report.keys.size(); ++k) {
+		packed |= uint32_t(report.keys[k]) << (9 + k);
+	}
+	return packed;
+}
+
+control::controller_report replay::unpack_report(uint32_t packed) {
+	control::controller_report report;
+	report.left_stick_dir = static_cast<control::controller_report::direction>(packed & 7);
+	report.right_stick_dir = static_cast<control::controller_report::direction>((packed >> 3) & 7);
+	report.active = (packed >> 6) & 1;
+	report.ltrigger = (packed >> 7) & 1;
+	report.rtrigger = (packed >> 8) & 1;
+	for (std::size_t k = 0; k < report.keys.size(); ++k) {
+		report.keys[k] = (packed >> (9 + k)) & 1;
+	}
+	return report;
+}
+
+void replay::write_reports(Bit_Writer& out, const control::movement_report_type& report,
+                           const control::movement_report_type& previous,
+                           std::size_t played) {
+	std::array<uint32_t, control::max_players> packed;
+	bool changed = false;
+	for (std::size_t i = 0; i < played; ++i) {
+		packed[i] = pack_report(report[i]);
+		changed |= packed[i] != pack_report(previous[i]);
+	}
+
+	out.write_bool(changed);
+	if (!changed) {
+		return;
+	}
+	for (std::size_t i = 0; i < played; ++i) {
+		bool slot_changed = packed[i] != pack_report(previous[i]);
+		out.write_bool(slot_changed);
+		if (slot_changed) {
+			out.write(packed[i], packed_bits);
+		}
+	}
+}
+
+// report holds the previous tick's inputs on entry
+void replay::read_reports(Bit_Reader& in, control::movement_report_type& report,
+                          std::size_t played) {
+	if (!in.read_bool()) {
+		return;
+	}
+	for (std::size_t i = 0; i < played; ++i) {
+		if (in.read_bool()) {
+			report[i] = unpack_report(in.read(packed_bits));
+		}
+	}
+}
+
+static control::movement_report_type empty_report() {
+	control::movement_report_type report;
+	report.fill(replay::unpack_report(0));
+	return report;
+}
+
+static void write_u32(Bit_Writer& out, uint32_t value) {
+	out.write_bytes(&value, sizeof(value));
+}
+
+static void write_u64(Bit_Writer& out, uint64_t value) {
+	out.write_bytes(&value, sizeof(value));
+}
+
+static void write_stream(std::ostream& out, const std::vector<uint8_t>& bytes) {
+	out.write(reinterpret_cast<const char*>(bytes.data()),
+	          static_cast<std::streamsize>(bytes.size()));
+}
+
+Replay_Recorder::Replay_Recorder(std::ostream& stream, const replay::header& header)
+    : out(stream), info(header), previous(empty_report()) {
+	Bit_Writer head;
+	write_u32(head, replay::magic);
+	write_u32(head, replay::version);
+	write_u32(head, info.seed);
+	write_u32(head, info.width);
+	write_u32(head, info.height);
+	head.write_bytes(&info.step, sizeof(info.step));
+	write_u32(head, info.keyframe_interval);
+	write_u32(head, info.players);
+
+	auto&& bytes = head.finish();
+	write_stream(out, bytes);
+	offset = bytes.size();
+}
+
+void Replay_Recorder::record(const game::World& world,
+                             const control::movement_report_type& report) {
+	if (ticks % info.keyframe_interval == 0) {
+		flush_block();
+		blocks.push_back(replay::block_entry{ticks, offset});
+
+		// Keyframe size first, so playing straight through can skip it
+		Bit_Writer keyframe;
+		replay::save_world(world, keyframe, info.players);
+		auto&& bytes = keyframe.finish();
+		write_u32(block, static_cast<uint32_t>(bytes.size()));
+		block.write_bytes(bytes.data(), bytes.size());
+		previous = empty_report();
+	}
+
+	replay::write_reports(block, report, previous, info.players);
+	previous = report;
+	ticks += 1;
+}
+
+void Replay_Recorder::finish(const game::World& world) {
+	flush_block();
+
+	Bit_Writer index;
+	write_u32(index, static_cast<uint32_t>(blocks.size()));
+	for (auto&& entry : blocks) {
+		write_u32(index, entry.first_tick);
+		write_u64(index, entry.offset);
+	}
+	write_u32(index, ticks);
+	write_u64(index, replay::checksum(world));
+	write_u64(index, offset);
+	write_u32(index, replay::magic);
+
+	auto&& bytes = index.finish();
+	write_stream(out, bytes);
+	offset += bytes.size();
+	out.flush();
+}
+
+void Replay_Recorder::flush_block() {
+	auto&& bytes = block.finish();
+	if (bytes.empty()) {
+		return;
+	}
+	write_stream(out, bytes);
+	offset += bytes.size();
+	block.clear();
+}
+
+uint32_t Replay_Recorder::get_tick_count() {
+	return ticks;
+}
+
+uint64_t Replay_Recorder::get_byte_count() {
+	return offset + block.bit_count() / 8;
+}
+
+bool Replay_Player::load(std::istream& in) {
+	data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	blocks.clear();
+	position = 0;
+
+	Bit_Reader head(data.data(), data.size());
+	uint32_t file_magic = 0, file_version = 0;
+	head.read_bytes(&file_magic, sizeof(file_magic));
+	head.read_bytes(&file_version, sizeof(file_version));
+	head.read_bytes(&info.seed, sizeof(info.seed));
+	head.read_bytes(&info.width, sizeof(info.width));
+	head.read_bytes(&info.height, sizeof(info.height));
+	head.read_bytes(&info.step, sizeof(info.step));
+	head.read_bytes(&info.keyframe_interval, sizeof(info.keyframe_interval));
+	head.read_bytes(&info.players, sizeof(info.players));
+	if (head.overflowed() || file_magic != replay::magic || file_version != replay::version ||
+	    info.keyframe_interval == 0 || info.players == 0 || info.players > control::max_players) {
+		return false;
+	}
+
+	// The index is found from the end of the file
+	constexpr std::size_t tail_size = sizeof(uint64_t) + sizeof(uint32_t);
+	if (data.size() < head.byte_position() + tail_size) {
+		return false;
+	}
+	Bit_Reader tail(data.data() + data.size() - tail_size, tail_size);
+	uint64_t index_offset = 0;
+	uint32_t end_magic = 0;
+	tail.read_bytes(&index_offset, sizeof(index_offset));
+	tail.read_bytes(&end_magic, sizeof(end_magic));
+	if (end_magic != replay::magic || index_offset >= data.size()) {
+		return false;
+	}
+
+	Bit_Reader index(data.data() + index_offset, data.size() - index_offset);
+	uint32_t count = 0;
+	index.read_bytes(&count, sizeof(count));
+	if (count > index.bytes_left()) {
+		return false;
+	}
+	// Seeking searches the blocks by first tick, so they have to be in order
+	blocks.resize(count);
+	for (std::size_t i = 0; i < blocks.size(); ++i) {
+		auto&& entry = blocks[i];
+		index.read_bytes(&entry.first_tick, sizeof(entry.first_tick));
+		index.read_bytes(&entry.offset, sizeof(entry.offset));
+		if (entry.offset >= index_offset ||
+		    (i > 0 && entry.first_tick <= blocks[i - 1].first_tick)) {
+			return false;
+		}
+	}
+	index.read_bytes(&tick_count, sizeof(tick_count));
+	index.read_bytes(&final_checksum, sizeof(final_checksum));
+
+	return !index.overflowed() && !blocks.empty();
+}
+
+// Points the reader at the start of a block's inputs, loading its keyframe into the
+// world or skipping over it
+bool Replay_Player::start_block(std::size_t index, bool load, game::World& world) {
+	auto&& entry = blocks[index];
+	auto end = index + 1 < blocks.size() ? blocks[index + 1].offset : data.size();
+	reader = Bit_Reader(data.data() + entry.offset, static_cast<std::size_t>(end - entry.offset));
+
+	uint32_t keyframe_size = 0;
+	reader.read_bytes(&keyframe_size, sizeof(keyframe_size));
+	if (load) {
+		if (!replay::load_world(world, reader, info.players)) {
+			return false;
+		}
+	}
+	else {
+		if (keyframe_size > reader.bytes_left()) {
+			return false;
+		}
+		reader = Bit_Reader(data.data() + entry.offset + sizeof(keyframe_size) + keyframe_size,
+		                    static_cast<std::size_t>(end - entry.offset) - sizeof(keyframe_size) -
+		                        keyframe_size);
+	}
+
+	block = index;
+	position = entry.first_tick;
+	previous = empty_report();
+	return !reader.overflowed();
+}
+
+bool Replay_Player::seek(game::World& world, uint32_t tick) {
+	if (blocks.empty() || tick > tick_count) {
+		return false;
+	}
+
+	// Last block starting at or before tick
+	auto after = std::upper_bound(
+	    blocks.begin() + 1, blocks.end(), tick,
+	    [](uint32_t t, const replay::block_entry& entry) { return t < entry.first_tick; });
+	auto index = static_cast<std::size_t>(after - blocks.begin()) - 1;
+	if (!start_block(index, true, world)) {
+		return false;
+	}
+	while (position < tick) {
+		if (!step(world)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Replay_Player::step(game::World& world) {
+	if (position >= tick_count) {
+		return false;
+	}
+	if (block + 1 < blocks.size() && blocks[block + 1].first_tick == position) {
+		if (!start_block(block + 1, false, world)) {
+			return false;
+		}
+	}
+
+	replay::read_reports(reader, previous, info.players);
+	if (reader.overflowed()) {
+		return false;
+	}
+	game::update(world, previous, info.step);
+	position += 1;
+	return true;
+}
+
+bool Replay_Player::verify(const game::World& world) {
+	return position == tick_count && replay::checksum(world) == final_checksum;
+}
+
+const replay::header& Replay_Player::get_header() {
+	return info;
+}
+
+uint32_t Replay_Player::get_tick_count() {
+	return tick_count;
+}
+
+uint32_t Replay_Player::get_position() {
+	return position;
+}
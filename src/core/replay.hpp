@@ -0,0 +1,125 @@
+#pragma once
+
+#include "bitstream.hpp"
+#include "controller_report.hpp"
+
+#include <cinttypes>
+#include <cstddef>
+#include <iosfwd>
+#include <vector>
+
+namespace game {
+	struct World;
+}
+
+// Replays are the inputs of every tick plus keyframes of the whole world.
+//
+// File layout, little endian:
+//   header    magic, version, seed, width, height, step, keyframe interval, players
+//   blocks    keyframe byte size, keyframe, then one packed input record per tick
+//   index     block count, (first tick, file offset) per block, tick count,
+//             checksum of the final world, index offset, magic
+//
+// Only the first players slots are stored, the rest must never be played. An input
+// record is one bit when nothing changed since the previous tick, otherwise a changed
+// bit per stored slot followed by the 24 bit packed report of the slots that did.
+// Each block starts from an empty previous report so it decodes on its own. Seeking
+// loads the nearest keyframe and simulates at most one interval of ticks.
+namespace replay {
+	constexpr uint32_t magic = 0x50524D42; // "BMRP"
+	constexpr uint32_t version = 6;
+
+	struct header {
+		uint32_t seed = 0;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		float step = 0;
+		uint32_t keyframe_interval = 600;
+		// Slots played, from the first one
+		uint32_t players = control::max_players;
+	};
+
+	struct block_entry {
+		uint32_t first_tick;
+		uint64_t offset;
+	};
+
+	// Every piece of world state that isn't derived, for the first played slots. The
+	// spatial index, blast queues and fired timers are rebuilt on the next tick so they
+	// aren't stored.
+	void save_world(const game::World& world, Bit_Writer& out,
+	                std::size_t played = control::max_players);
+	// False if the data is cut short or inconsistent, the world is unusable then. Slots
+	// past played are put back how a match starts them.
+	bool load_world(game::World& world, Bit_Reader& in,
+	                std::size_t played = control::max_players);
+	// FNV-1a of the saved world, equal worlds give equal checksums
+	uint64_t checksum(const game::World& world);
+
+	// One controller's report in packed_bits bits, also what rollback sessions send
+	constexpr unsigned packed_bits = 24;
+	uint32_t pack_report(const control::controller_report& report);
+	control::controller_report unpack_report(uint32_t packed);
+
+	// Input record of the first played slots
+	void write_reports(Bit_Writer& out, const control::movement_report_type& report,
+	                   const control::movement_report_type& previous, std::size_t played);
+	void read_reports(Bit_Reader& in, control::movement_report_type& report,
+	                  std::size_t played);
+}
+
+// Call record with the world and inputs of every tick before handing them to
+// game::update, and finish once the match is over.
+class Replay_Recorder {
+  public:
+	Replay_Recorder(std::ostream& out, const replay::header& info);
+
+	void record(const game::World& world, const control::movement_report_type& report);
+	void finish(const game::World& world);
+
+	uint32_t get_tick_count();
+	uint64_t get_byte_count();
+
+  private:
+	void flush_block();
+
+	std::ostream& out;
+	replay::header info;
+	Bit_Writer block;
+	control::movement_report_type previous;
+	std::vector<replay::block_entry> blocks;
+	uint32_t ticks = 0;
+	uint64_t offset = 0;
+};
+
+class Replay_Player {
+  public:
+	// Reads a whole replay into memory, false if it isn't one
+	bool load(std::istream& in);
+
+	// Puts the world at the state before the given tick. Costs one keyframe load and
+	// at most keyframe_interval ticks whatever the position.
+	bool seek(game::World& world, uint32_t tick);
+	// Plays one tick, false at the end of the replay
+	bool step(game::World& world);
+	// At the end of the replay, whether the world matches the one that was recorded
+	bool verify(const game::World& world);
+
+	const replay::header& get_header();
+	uint32_t get_tick_count();
+	uint32_t get_position();
+
+  private:
+	bool start_block(std::size_t index, bool load, game::World& world);
+
+	std::vector<uint8_t> data;
+	replay::header info;
+	std::vector<replay::block_entry> blocks;
+	uint32_t tick_count = 0;
+	uint64_t final_checksum = 0;
+
+	Bit_Reader reader{nullptr, 0};
+	std::size_t block = 0;
+	uint32_t position = 0;
+	control::movement_report_type previous;
+};
@@ -0,0 +1,220 @@
+#include "rollback.hpp"
+#include "game.hpp"
+#include "replay.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+constexpr uint32_t Rollback_Session::history;
+
+// A player that is present but not touching anything
+static uint32_t idle_report() {
+	control::controller_report report = replay::unpack_report(0);
+	report.active = true;
+	return replay::pack_report(report);
+}
+
+Rollback_Session::Rollback_Session(game::World& world_, float step_, const settings& config_)
+    : world(world_), step(step_), config(config_), ring(config_.max_rollback + 2),
+      ring_checksums(ring.get_frame_count(), 0) {
+	config.player_count = std::min<std::size_t>(config.player_count, slots.size());
+
+	// The first input_delay ticks have no local input yet, every player idles through them
+	auto start = world.tick;
+	for (std::size_t s = 0; s < slots.size(); ++s) {
+		auto&& in = slots[s];
+		in.packed.fill(s < config.player_count ? idle_report() : 0);
+		in.confirmed_through = static_cast<int64_t>(start + config.input_delay) - 1;
+		in.acked = start + config.input_delay;
+	}
+	checksums.assign(start, 0);
+}
+
+bool Rollback_Session::is_remote(std::size_t slot) const {
+	return slot < config.player_count && slot != config.local_slot;
+}
+
+uint32_t Rollback_Session::get_frame() const {
+	return world.tick;
+}
+
+int64_t Rollback_Session::get_confirmed() const {
+	int64_t confirmed = slots[0].confirmed_through;
+	for (std::size_t s = 1; s < config.player_count; ++s) {
+		confirmed = std::min(confirmed, slots[s].confirmed_through);
+	}
+	return confirmed;
+}
+
+bool Rollback_Session::advance(const control::controller_report& local) {
+	synchronize();
+
+	auto frame = static_cast<int64_t>(world.tick);
+	if (frame - get_confirmed() > static_cast<int64_t>(config.max_rollback)) {
+		counters.stalls += 1;
+		return false;
+	}
+
+	auto&& in = slots[config.local_slot];
+	auto tick = static_cast<uint32_t>(in.confirmed_through + 1);
+	auto report = local;
+	report.active = true;
+	in.packed[tick % history] = replay::pack_report(report);
+	in.confirmed_through = tick;
+
+	simulate();
+	counters.frames += 1;
+	return true;
+}
+
+void Rollback_Session::synchronize() {
+	if (rollback_to >= 0) {
+		auto start = std::chrono::steady_clock::now();
+		auto frame = world.tick;
+		auto target = static_cast<uint32_t>(rollback_to);
+		if (ring.restore(world, target)) {
+			while (world.tick < frame) {
+				simulate();
+			}
+			counters.rollbacks += 1;
+			counters.resimulated += frame - target;
+			counters.max_depth = std::max(counters.max_depth, frame - target);
+		}
+		rollback_to = -1;
+
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		counters.resimulate_seconds += elapsed.count();
+		counters.max_frame_seconds = std::max(counters.max_frame_seconds, elapsed.count());
+	}
+
+	record_checksums();
+}
+
+// Plays world.tick with the confirmed inputs where there are some and the last
+// confirmed input of the player where there aren't
+void Rollback_Session::simulate() {
+	auto tick = world.tick;
+	ring.save(world);
+	if (config.sync_checks) {
+		ring_checksums[tick % ring_checksums.size()] = replay::checksum(world);
+	}
+
+	control::movement_report_type report;
+	for (std::size_t s = 0; s < slots.size(); ++s) {
+		auto&& in = slots[s];
+		if (static_cast<int64_t>(tick) > in.confirmed_through) {
+			auto last = static_cast<uint64_t>(std::max<int64_t>(in.confirmed_through, 0));
+			in.packed[tick % history] = in.packed[last % history];
+		}
+		report[s] = replay::unpack_report(in.packed[tick % history]);
+	}
+
+	game::update(world, report, step);
+}
+
+void Rollback_Session::record_checksums() {
+	if (!config.sync_checks) {
+		return;
+	}
+
+	// The world at tick g is final once every input before g is confirmed
+	auto confirmed = get_confirmed();
+	while (static_cast<int64_t>(checksums.size()) <= confirmed + 1 &&
+	       checksums.size() <= world.tick) {
+		auto tick = static_cast<uint32_t>(checksums.size());
+		if (tick == world.tick) {
+			checksums.push_back(replay::checksum(world));
+		}
+		else if (ring.contains(tick)) {
+			checksums.push_back(ring_checksums[tick % ring_checksums.size()]);
+		}
+		else {
+			break;
+		}
+	}
+}
+
+// Datagram layout: sender slot (8 bits), first tick the sender still needs from the
+// receiver (32), first tick carried (32), input count (8), then per input a changed
+// bit and, if set, the packed report
+void Rollback_Session::write_packet(std::size_t slot, Bit_Writer& out) const {
+	auto&& local = slots[config.local_slot];
+	auto&& peer = slots[slot];
+
+	out.clear();
+	out.write(static_cast<uint32_t>(config.local_slot), 8);
+	out.write(static_cast<uint32_t>(peer.confirmed_through + 1), 32);
+
+	// Everything the peer hasn't acknowledged, at most the last history ticks and 255
+	// of them
+	auto end = static_cast<uint32_t>(local.confirmed_through + 1);
+	auto first = peer.acked;
+	uint32_t count = 0;
+	if (first < end) {
+		if (end - first > history) {
+			first = end - history;
+		}
+		count = std::min<uint32_t>(end - first, 255);
+	}
+	out.write(first, 32);
+	out.write(count, 8);
+
+	uint32_t previous = 0;
+	for (uint32_t k = 0; k < count; ++k) {
+		auto value = local.packed[(first + k) % history];
+		out.write_bool(value != previous);
+		if (value != previous) {
+			out.write(value, replay::packed_bits);
+		}
+		previous = value;
+	}
+}
+
+bool Rollback_Session::read_packet(const uint8_t* data, std::size_t size) {
+	Bit_Reader in(data, size);
+	auto from = in.read(8);
+	auto ack = in.read(32);
+	auto first = in.read(32);
+	auto count = in.read(8);
+
+	std::array<uint32_t, 255> values;
+	uint32_t previous = 0;
+	for (uint32_t k = 0; k < count; ++k) {
+		if (in.read_bool()) {
+			previous = in.read(replay::packed_bits);
+		}
+		values[k] = previous;
+	}
+
+	if (in.overflowed() || !is_remote(from)) {
+		counters.packets_rejected += 1;
+		return false;
+	}
+	counters.packets_read += 1;
+
+	auto&& peer = slots[from];
+	peer.acked = std::max(peer.acked, ack);
+
+	// Only inputs that extend the confirmed run are taken, anything past a gap comes
+	// again in a later datagram
+	auto next = static_cast<uint32_t>(peer.confirmed_through + 1);
+	for (uint32_t k = 0; k < count; ++k) {
+		auto tick = first + k;
+		if (tick < next) {
+			continue;
+		}
+		if (tick != next || (tick >= world.tick && tick - world.tick >= history / 2)) {
+			break;
+		}
+
+		auto&& slot_value = peer.packed[tick % history];
+		if (tick < world.tick && slot_value != values[k] &&
+		    (rollback_to < 0 || static_cast<int64_t>(tick) < rollback_to)) {
+			rollback_to = tick;
+		}
+		slot_value = values[k];
+		peer.confirmed_through = tick;
+		next = tick + 1;
+	}
+	return true;
+}
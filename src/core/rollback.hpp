@@ -0,0 +1,111 @@
+#pragma once
+
+#include "bitstream.hpp"
+#include "controller_report.hpp"
+#include "snapshot_ring.hpp"
+
+#include <array>
+#include <cinttypes>
+#include <cstddef>
+#include <vector>
+
+namespace game {
+	struct World;
+}
+
+// Peer to peer rollback. Every peer runs the whole match and only controller reports
+// travel between them. Remote inputs that haven't arrived are predicted by repeating
+// the last one that did; when a real input turns out different, the world goes back
+// to the snapshot before that tick and the ticks since are simulated again.
+//
+// Local inputs are played input_delay ticks after they are given, which hides that
+// much latency without any rollback. A peer never runs more than max_rollback ticks
+// past the last tick it has every input for, it stalls instead.
+//
+// The session doesn't own a transport. write_packet makes the datagram for one peer,
+// read_packet takes one from any peer. Each datagram carries every local input the
+// peer hasn't acknowledged yet, so lost or reordered datagrams cost nothing but time.
+class Rollback_Session {
+  public:
+	struct settings {
+		// Slot controlled here, slots [0, player_count) are players, the rest are empty
+		std::size_t local_slot = 0;
+		std::size_t player_count = 2;
+		uint32_t input_delay = 2;
+		uint32_t max_rollback = 8;
+		// Keep a checksum of the world at every fully confirmed tick, see get_checksums
+		bool sync_checks = false;
+	};
+
+	struct stats {
+		uint64_t frames = 0;
+		// Calls to advance that couldn't simulate because remote inputs were too old
+		uint64_t stalls = 0;
+		uint64_t rollbacks = 0;
+		// Ticks simulated again, and the most in a single rollback
+		uint64_t resimulated = 0;
+		uint32_t max_depth = 0;
+		// Wall time spent simulating again, in total and in the worst frame
+		double resimulate_seconds = 0;
+		double max_frame_seconds = 0;
+		uint64_t packets_read = 0;
+		uint64_t packets_rejected = 0;
+	};
+
+	// The world must already be initialized the same way on every peer
+	Rollback_Session(game::World& world, float step, const settings& config);
+
+	// Takes this tick's local input and simulates one tick, after applying any
+	// rollback that arrived packets call for. False if it stalled instead.
+	bool advance(const control::controller_report& local);
+	// Applies pending rollbacks without simulating a new tick
+	void synchronize();
+
+	// Datagram for the peer playing the given slot
+	void write_packet(std::size_t slot, Bit_Writer& out) const;
+	// False if the datagram is malformed or from a slot that isn't a remote player
+	bool read_packet(const uint8_t* data, std::size_t size);
+
+	// Next tick to simulate
+	uint32_t get_frame() const;
+	// Last tick every player's input is known for, -1 before the first
+	int64_t get_confirmed() const;
+	const stats& get_stats() const {
+		return counters;
+	}
+	// Checksum of the world at the start of every tick up to get_confirmed() + 1,
+	// indexed by tick. Only kept with sync_checks.
+	const std::vector<uint64_t>& get_checksums() const {
+		return checksums;
+	}
+
+  private:
+	// Inputs are kept for this many ticks around the current one
+	static constexpr uint32_t history = 512;
+
+	struct slot_inputs {
+		// Packed reports by tick modulo history, the real one once confirmed, otherwise
+		// the prediction that was simulated
+		std::array<uint32_t, history> packed;
+		std::array<bool, history> confirmed;
+		// Highest tick with every tick up to it confirmed
+		int64_t confirmed_through = -1;
+		// First tick of our inputs that the peer playing this slot still needs
+		uint32_t acked = 0;
+	};
+
+	bool is_remote(std::size_t slot) const;
+	void simulate();
+	void record_checksums();
+
+	game::World& world;
+	float step;
+	settings config;
+	Snapshot_Ring ring;
+	std::vector<uint64_t> ring_checksums;
+	std::array<slot_inputs, control::max_players> slots;
+	// Earliest tick simulated with a wrong prediction, -1 if none
+	int64_t rollback_to = -1;
+	std::vector<uint64_t> checksums;
+	stats counters;
+};
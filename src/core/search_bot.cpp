@@ -0,0 +1,308 @@
+#include "search_bot.hpp"
+#include "game.hpp"
+#include "gamegrid.hpp"
+#include "player.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using direction = control::controller_report::direction;
+
+static constexpr uint32_t no_node = 0xFFFFFFFF;
+
+// Choices past the first four map onto directions in order: up, down, left, right
+static constexpr std::size_t first_move = 1;
+static constexpr std::size_t fire = 5;
+static constexpr std::size_t drop_bomb = 6;
+
+// Deepest a descent can go, the horizon is clamped to it
+static constexpr uint32_t max_depth = 63;
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count();
+}
+
+static control::controller_report idle_report() {
+	control::controller_report report = {};
+	report.active = true;
+	return report;
+}
+
+static control::controller_report choice_report(std::size_t choice) {
+	auto report = idle_report();
+	if (choice >= first_move && choice < fire) {
+		report.left_stick_dir = static_cast<direction>(choice);
+	}
+	report.rtrigger = choice == fire;
+	report.ltrigger = choice == drop_bomb;
+	return report;
+}
+
+// Whether moving in d from the slot's cell stays on the grid and off traps
+static bool safe_move(const game::World& world, std::size_t slot, direction d) {
+	auto x = world.players.loc_x[slot];
+	auto y = world.players.loc_y[slot];
+	switch (d) {
+		case direction::up:
+			if (y == 0) {
+				return false;
+			}
+			y -= 1;
+			break;
+		case direction::down:
+			if (y + 1 >= world.grid.height) {
+				return false;
+			}
+			y += 1;
+			break;
+		case direction::left:
+			if (x == 0) {
+				return false;
+			}
+			x -= 1;
+			break;
+		case direction::right:
+			if (x + 1 >= world.grid.width) {
+				return false;
+			}
+			x += 1;
+			break;
+		default:
+			return true;
+	}
+	return !gamegrid::test(world.grid, gamegrid::StateType::trap, x, y);
+}
+
+static bool legal(const game::World& world, std::size_t slot, std::size_t choice) {
+	auto&& ps = world.players;
+	if (choice >= first_move && choice < fire) {
+		return safe_move(world, slot, static_cast<direction>(choice));
+	}
+	if (choice == fire) {
+		return ps.ammo_count[slot] >= 1 && world.tick >= ps.bullet_ready[slot];
+	}
+	if (choice == drop_bomb) {
+		return ps.power[slot] == players::player_info::powerup::bomb &&
+		       world.tick >= ps.bomb_ready[slot];
+	}
+	return true;
+}
+
+// Random policy for playouts: keep walking the same way most of the time, never onto a
+// trap, and now and then shoot or drop a bomb
+static control::controller_report policy(const game::World& world, std::size_t slot,
+                                         direction& held, Random& prng) {
+	auto&& ps = world.players;
+	if (!ps.active[slot]) {
+		return control::controller_report{};
+	}
+	auto report = idle_report();
+	if (!ps.animated[slot]) {
+		if (held == direction::none || prng.below(4) == 0 || !safe_move(world, slot, held)) {
+			held = direction::none;
+			auto start = prng.below(4);
+			for (uint32_t k = 0; k < 4; ++k) {
+				auto d = static_cast<direction>(first_move + (start + k) % 4);
+				if (safe_move(world, slot, d)) {
+					held = d;
+					break;
+				}
+			}
+		}
+		report.left_stick_dir = held;
+	}
+	report.rtrigger = ps.ammo_count[slot] >= 1 && prng.below(16) == 0;
+	report.ltrigger =
+	    ps.power[slot] == players::player_info::powerup::bomb && prng.below(32) == 0;
+	return report;
+}
+
+Search_Bot::Search_Bot(const settings& config_) : config(config_) {
+	auto count = std::max<std::size_t>(config.threads, 1);
+	if (count > 1) {
+		pool = std::make_unique<Thread_Pool>(count);
+	}
+	workers.resize(count);
+	for (std::size_t i = 0; i < count; ++i) {
+		auto&& w = workers[i];
+		w.world = std::make_unique<game::World>();
+		w.tree.reserve(std::max<std::size_t>(config.tree_capacity, 1));
+		w.prng.seed(config.seed + i);
+	}
+}
+
+Search_Bot::~Search_Bot() = default;
+
+control::controller_report Search_Bot::decide(const game::World& world, std::size_t slot) {
+	if (!world.players.active[slot] || world.players.animated[slot]) {
+		return idle_report();
+	}
+
+	step = world.step > 0 ? world.step : 1.0f / 60.0f;
+	choice_ticks = std::max(static_cast<uint32_t>(std::ceil(players::move_duration / step)), 1u);
+	deadline = std::chrono::steady_clock::now() +
+	           std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+	               std::chrono::duration<double>(config.budget));
+
+	if (!pool) {
+		search(workers[0], world, slot);
+	}
+	else {
+		for (auto&& w : workers) {
+			pool->submit([this, &w, &world, slot] { search(w, world, slot); });
+		}
+		pool->wait();
+	}
+
+	std::array<uint64_t, choice_count> visits = {};
+	for (auto&& w : workers) {
+		auto&& root = w.tree[0];
+		for (uint32_t c = 0; c < root.child_count; ++c) {
+			auto&& child = w.tree[root.first_child + c];
+			visits[child.choice] += child.visits;
+		}
+		counters.playouts += w.playouts;
+		counters.states += w.states;
+		counters.worker_seconds += w.seconds;
+	}
+	counters.decisions += 1;
+
+	auto best = std::max_element(visits.begin(), visits.end()) - visits.begin();
+	return choice_report(visits[best] > 0 ? static_cast<std::size_t>(best) : 0);
+}
+
+void Search_Bot::search(worker& w, const game::World& root, std::size_t slot) {
+	auto start = std::chrono::steady_clock::now();
+	auto horizon = std::min(std::max(config.horizon, 1u), max_depth);
+	auto&& world = *w.world;
+	auto&& tree = w.tree;
+	tree.clear();
+	tree.push_back(node{no_node, 0, 0, 0, 0, 0.0f});
+	w.playouts = 0;
+	w.states = 0;
+
+	std::array<uint32_t, max_depth + 2> path;
+	while (config.max_playouts == 0 || w.playouts < config.max_playouts) {
+		if (std::chrono::steady_clock::now() >= deadline) {
+			break;
+		}
+
+		// Fork the root
+		game::save_snapshot(root, &world);
+		w.held.fill(direction::none);
+		auto&& self = world.players;
+		auto kills = world.kills[slot];
+		auto deaths = world.deaths[slot];
+		auto ammo = self.ammo_count[slot];
+		auto had_bomb = self.power[slot] == players::player_info::powerup::bomb;
+
+		// Walk down the tree, trying every child once before picking by UCT
+		uint32_t n = 0;
+		uint32_t depth = 0;
+		std::size_t length = 0;
+		path[length++] = n;
+		bool alive = true;
+		while (alive && tree[n].child_count > 0) {
+			auto&& parent = tree[n];
+			auto log_visits = std::log(static_cast<float>(std::max(parent.visits, 1u)));
+			auto chosen = parent.first_child;
+			auto best = -1.0f;
+			for (uint32_t c = 0; c < parent.child_count; ++c) {
+				auto&& child = tree[parent.first_child + c];
+				if (child.visits == 0) {
+					chosen = parent.first_child + c;
+					break;
+				}
+				auto visits = static_cast<float>(child.visits);
+				auto score =
+				    child.value / visits + config.exploration * std::sqrt(log_visits / visits);
+				if (score > best) {
+					best = score;
+					chosen = parent.first_child + c;
+				}
+			}
+			n = chosen;
+			path[length++] = n;
+			alive = play(w, slot, tree[n].choice);
+			depth += 1;
+		}
+
+		// Grow the tree by a leaf that has been played out before
+		if (alive && depth < horizon && (n == 0 || tree[n].visits > 0) &&
+		    expand(w, n, slot) > 0) {
+			n = tree[n].first_child;
+			path[length++] = n;
+			alive = play(w, slot, tree[n].choice);
+			depth += 1;
+		}
+
+		// Play out the rest with the same policy as everyone else
+		while (alive && depth < horizon) {
+			auto report = policy(world, slot, w.held[slot], w.prng);
+			auto choice = static_cast<std::size_t>(report.left_stick_dir);
+			if (report.rtrigger) {
+				choice = fire;
+			}
+			else if (report.ltrigger) {
+				choice = drop_bomb;
+			}
+			alive = play(w, slot, choice);
+			depth += 1;
+		}
+
+		auto kill_score = static_cast<float>(world.kills[slot] - kills);
+		auto death_score = static_cast<float>(world.deaths[slot] - deaths);
+		auto ammo_score = static_cast<float>(self.ammo_count[slot]) - static_cast<float>(ammo);
+		auto bomb_score =
+		    !had_bomb && self.power[slot] == players::player_info::powerup::bomb ? 1.0f : 0.0f;
+		auto reward = 0.5f + 0.25f * (kill_score - 2.0f * death_score + 0.05f * ammo_score +
+		                              0.25f * bomb_score);
+		reward = std::min(std::max(reward, 0.0f), 1.0f);
+
+		for (std::size_t k = 0; k < length; ++k) {
+			tree[path[k]].visits += 1;
+			tree[path[k]].value += reward;
+		}
+		w.playouts += 1;
+	}
+	w.seconds = seconds_since(start);
+}
+
+bool Search_Bot::play(worker& w, std::size_t slot, std::size_t choice) {
+	auto&& world = *w.world;
+	auto deaths = world.deaths[slot];
+	control::movement_report_type report;
+	for (uint32_t t = 0; t < choice_ticks; ++t) {
+		for (std::size_t s = 0; s < report.size(); ++s) {
+			if (s == slot) {
+				report[s] = t == 0 ? choice_report(choice) : idle_report();
+			}
+			else {
+				report[s] = policy(world, s, w.held[s], w.prng);
+			}
+		}
+		game::update(world, report, step);
+		w.states += 1;
+		if (world.deaths[slot] != deaths) {
+			return false;
+		}
+	}
+	return true;
+}
+
+std::size_t Search_Bot::expand(worker& w, uint32_t parent, std::size_t slot) {
+	auto&& tree = w.tree;
+	if (tree.size() + choice_count > tree.capacity()) {
+		return 0;
+	}
+	auto first = static_cast<uint32_t>(tree.size());
+	for (std::size_t choice = 0; choice < choice_count; ++choice) {
+		if (legal(*w.world, slot, choice)) {
+			tree.push_back(node{parent, 0, 0, static_cast<uint8_t>(choice), 0, 0.0f});
+		}
+	}
+	tree[parent].first_child = first;
+	tree[parent].child_count = static_cast<uint8_t>(tree.size() - first);
+	return tree[parent].child_count;
+}
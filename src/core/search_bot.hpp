@@ -0,0 +1,106 @@
+#pragma once
+
+#include "controller_report.hpp"
+#include "random.hpp"
+#include "thread_pool.hpp"
+
+#include <array>
+#include <chrono>
+#include <cinttypes>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace game {
+	struct World;
+}
+
+// Bot that picks its next move by Monte-Carlo tree search over the real game rules.
+// Each choice lasts as long as a move between cells. The tree is open loop: it only
+// holds the bot's own choices and every playout forks the world from the root again,
+// which is one copy of its bytes. Other players and the rest of a playout follow a
+// cheap random policy that keeps away from traps.
+//
+// The search is root parallel. Every worker grows its own tree in its own world for
+// the whole budget and the visit counts of the first choices are added up at the end,
+// so workers never share anything while searching. Trees and worlds are allocated up
+// front, nothing allocates during a search.
+//
+// With a time budget the choice depends on how fast the machine is. Matches with
+// search bots are only reproducible from their replays.
+class Search_Bot {
+  public:
+	struct settings {
+		// Seconds per choice, and playouts per worker per choice, whichever runs out
+		// first. No playout limit when 0.
+		double budget = 0.002;
+		uint32_t max_playouts = 0;
+		std::size_t threads = 1;
+		// Choices simulated past the root before a playout is scored
+		uint32_t horizon = 8;
+		// Nodes per worker tree
+		std::size_t tree_capacity = 1 << 14;
+		float exploration = 1.4f;
+		uint64_t seed = 0;
+	};
+
+	struct stats {
+		uint64_t decisions = 0;
+		uint64_t playouts = 0;
+		// Ticks simulated by playouts, and the time workers spent on them
+		uint64_t states = 0;
+		double worker_seconds = 0;
+	};
+
+	explicit Search_Bot(const settings& config);
+	~Search_Bot();
+
+	Search_Bot(const Search_Bot&) = delete;
+	Search_Bot& operator=(const Search_Bot&) = delete;
+
+	// Input for the player in slot. Searches when the player can start a move and
+	// otherwise holds still.
+	control::controller_report decide(const game::World& world, std::size_t slot);
+
+	const stats& get_stats() const {
+		return counters;
+	}
+
+  private:
+	// Choices: standing, the four moves, firing and dropping a bomb
+	static constexpr std::size_t choice_count = 7;
+
+	struct node {
+		uint32_t parent;
+		uint32_t first_child;
+		uint8_t child_count;
+		uint8_t choice;
+		uint32_t visits;
+		float value;
+	};
+
+	struct worker {
+		std::unique_ptr<game::World> world;
+		std::vector<node> tree;
+		Random prng;
+		// Stick direction each player's policy holds
+		std::array<control::controller_report::direction, control::max_players> held;
+		uint64_t playouts;
+		uint64_t states;
+		double seconds;
+	};
+
+	void search(worker& w, const game::World& root, std::size_t slot);
+	// Plays one choice for slot, false if the player died during it
+	bool play(worker& w, std::size_t slot, std::size_t choice);
+	std::size_t expand(worker& w, uint32_t parent, std::size_t slot);
+
+	settings config;
+	std::unique_ptr<Thread_Pool> pool;
+	std::vector<worker> workers;
+	// Length of a tick in the root, and the ticks one choice lasts
+	float step = 0;
+	uint32_t choice_ticks = 1;
+	std::chrono::steady_clock::time_point deadline;
+	stats counters;
+};
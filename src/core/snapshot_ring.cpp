@@ -0,0 +1,47 @@
+#include "snapshot_ring.hpp"
+#include "game.hpp"
+
+#include <algorithm>
+#include <limits>
+
+static constexpr uint64_t no_tick = std::numeric_limits<uint64_t>::max();
+
+Snapshot_Ring::Snapshot_Ring(std::size_t frames)
+    : ticks(std::max<std::size_t>(frames, 1), no_tick) {}
+
+void Snapshot_Ring::reset(const game::World& world) {
+	frame_size = game::snapshot_size(world);
+	storage.assign(frame_size * ticks.size(), 0);
+	std::fill(ticks.begin(), ticks.end(), no_tick);
+}
+
+void Snapshot_Ring::save(const game::World& world) {
+	if (game::snapshot_size(world) != frame_size) {
+		reset(world);
+	}
+
+	auto frame = world.tick % ticks.size();
+	game::save_snapshot(world, storage.data() + frame * frame_size);
+	ticks[frame] = world.tick;
+}
+
+bool Snapshot_Ring::restore(game::World& world, uint32_t tick) const {
+	if (!contains(tick)) {
+		return false;
+	}
+
+	game::load_snapshot(world, storage.data() + (tick % ticks.size()) * frame_size, frame_size);
+	return true;
+}
+
+bool Snapshot_Ring::contains(uint32_t tick) const {
+	return ticks[tick % ticks.size()] == tick;
+}
+
+void Snapshot_Ring::discard_after(uint32_t tick) {
+	for (auto&& t : ticks) {
+		if (t != no_tick && t > tick) {
+			t = no_tick;
+		}
+	}
+}
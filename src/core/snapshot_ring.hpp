@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <vector>
+
+namespace game {
+	struct World;
+}
+
+// The last few ticks of a match, for rollback and for search. Every frame is allocated
+// up front at the world's snapshot size, saving and restoring are one memcpy each and
+// never allocate. A frame is found by tick modulo the frame count.
+class Snapshot_Ring {
+  public:
+	explicit Snapshot_Ring(std::size_t frames);
+
+	// Sizes the frames for the world and forgets everything saved. Saving a world of
+	// a different size calls this first.
+	void reset(const game::World& world);
+
+	// Stores the world under its current tick, over whatever was frames ticks ago
+	void save(const game::World& world);
+	// False, leaving the world alone, if the tick isn't in the ring
+	bool restore(game::World& world, uint32_t tick) const;
+	bool contains(uint32_t tick) const;
+	// Drops every frame after tick, for when the ticks after it are simulated again
+	void discard_after(uint32_t tick);
+
+	std::size_t get_frame_count() const {
+		return ticks.size();
+	}
+	std::size_t get_frame_size() const {
+		return frame_size;
+	}
+
+  private:
+	std::vector<unsigned char> storage;
+	// Tick each frame holds, or no_tick
+	std::vector<uint64_t> ticks;
+	std::size_t frame_size = 0;
+};
@@ -0,0 +1,46 @@
+#include "spatial_index.hpp"
+#include "game.hpp"
+#include "player.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// Players are listed in the cell nearest to them
+static void insert_player(game::World& world, std::size_t index) {
+	if (!world.players.active[index]) {
+		return;
+	}
+
+	auto loc = players::location(world.players, index);
+	auto cell = std::lround(loc.y) * static_cast<long>(world.grid.width) + std::lround(loc.x);
+	world.index.players.insert(static_cast<int32_t>(cell), static_cast<uint32_t>(index), loc.x,
+	                           loc.y);
+}
+
+void spatial::index_players(game::World& world) {
+	auto&& map = world.index.players;
+	map.clear();
+	for (std::size_t i = 0; i < world.players.size(); ++i) {
+		insert_player(world, i);
+	}
+	map.sort();
+}
+
+void spatial::index_bombs(game::World& world) {
+	auto&& map = world.index.bombs;
+	auto&& bombs = world.bombs;
+	auto width = world.grid.width;
+	map.clear();
+	for (std::size_t i = 0; i < bombs.size(); ++i) {
+		map.insert(static_cast<int32_t>(bombs.y[i] * width + bombs.x[i]), static_cast<uint32_t>(i),
+		           static_cast<float>(bombs.x[i]), static_cast<float>(bombs.y[i]));
+	}
+	map.sort();
+}
+
+void spatial::update_player(game::World& world, std::size_t player_index) {
+	auto&& map = world.index.players;
+	map.remove(static_cast<uint32_t>(player_index));
+	insert_player(world, player_index);
+	map.sort();
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "bomb.hpp"
+#include "controller_report.hpp"
+#include "fixed_vector.hpp"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstddef>
+
+namespace game {
+	struct World;
+}
+
+// Per-tick broadphase over the game grid. Each kind of entity gets a list of
+// (cell, id) entries sorted by cell, so finding what is in a cell is a binary
+// search and the cost doesn't depend on how big the grid is. Positions are stored
+// with the entries so narrow phase tests don't have to recompute them.
+namespace spatial {
+	struct entry {
+		int32_t cell;
+		uint32_t id;
+		float x, y;
+	};
+
+	inline bool entry_less(const entry& lhs, const entry& rhs) {
+		return lhs.cell < rhs.cell || (lhs.cell == rhs.cell && lhs.id < rhs.id);
+	}
+
+	// Sized for the most entities of one kind that can exist at once
+	template <std::size_t Capacity>
+	struct cell_map {
+		Fixed_Vector<entry, Capacity> entries;
+
+		void clear() {
+			entries.clear();
+		}
+		void insert(int32_t cell, uint32_t id, float x, float y) {
+			entries.push_back(entry{cell, id, x, y});
+		}
+		// Must be called after inserting and before querying. Entries are mostly in
+		// order from the last tick, insertion sort is near linear then.
+		void sort() {
+			for (std::size_t i = 1; i < entries.size(); ++i) {
+				auto value = entries[i];
+				std::size_t j = i;
+				for (; j > 0 && entry_less(value, entries[j - 1]); --j) {
+					entries[j] = entries[j - 1];
+				}
+				entries[j] = value;
+			}
+		}
+		void remove(uint32_t id) {
+			entries.resize(static_cast<std::size_t>(
+			    std::remove_if(entries.begin(), entries.end(),
+			                   [id](auto&& e) { return e.id == id; }) -
+			    entries.begin()));
+		}
+		const entry* begin(int32_t cell) const {
+			return std::lower_bound(entries.begin(), entries.end(), cell,
+			                        [](auto&& e, int32_t c) { return e.cell < c; });
+		}
+		const entry* end(int32_t cell) const {
+			return std::upper_bound(entries.begin(), entries.end(), cell,
+			                        [](int32_t c, auto&& e) { return c < e.cell; });
+		}
+	};
+
+	struct SpatialIndex {
+		// Players are in the cell nearest to their interpolated location
+		cell_map<control::max_players> players;
+		cell_map<bomb::max_bombs> bombs;
+	};
+
+	// Half size of the box used for player hit tests
+	constexpr double player_radius = 0.7;
+
+	void index_players(game::World& world);
+	void index_bombs(game::World& world);
+	void update_player(game::World& world, std::size_t player_index);
+
+	// Calls f(entry) for every player whose location is inside the box. Each row of the
+	// box is one contiguous run of cells, so it takes one search per row.
+	template <class F>
+	void players_in_box(const SpatialIndex& index, std::size_t width, std::size_t height,
+	                    float min_x, float min_y, float max_x, float max_y, F&& f) {
+		auto first_x = std::max(std::lround(min_x), 0L);
+		auto last_x = std::min(std::lround(max_x), static_cast<long>(width) - 1);
+		auto first_y = std::max(std::lround(min_y), 0L);
+		auto last_y = std::min(std::lround(max_y), static_cast<long>(height) - 1);
+		if (first_x > last_x) {
+			return;
+		}
+
+		auto&& map = index.players;
+		for (long j = first_y; j <= last_y; ++j) {
+			auto row = j * static_cast<long>(width);
+			auto it = map.begin(static_cast<int32_t>(row + first_x));
+			auto end = map.entries.end();
+			for (; it != end && it->cell <= row + last_x; ++it) {
+				if (min_x <= it->x && it->x <= max_x && min_y <= it->y && it->y <= max_y) {
+					f(*it);
+				}
+			}
+		}
+	}
+}
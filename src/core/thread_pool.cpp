@@ -0,0 +1,115 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+// Index of the pool worker running on this thread, so tasks spawned from inside a
+// task land on the local deque.
+static thread_local const Thread_Pool* current_pool = nullptr;
+static thread_local std::size_t current_worker = 0;
+
+Thread_Pool::Thread_Pool(std::size_t thread_count) {
+	thread_count = std::max<std::size_t>(thread_count, 1);
+
+	queues.reserve(thread_count);
+	for (std::size_t i = 0; i < thread_count; ++i) {
+		queues.emplace_back(std::make_unique<worker_queue>());
+	}
+
+	threads.reserve(thread_count);
+	for (std::size_t i = 0; i < thread_count; ++i) {
+		threads.emplace_back(&Thread_Pool::worker, this, i);
+	}
+}
+
+Thread_Pool::~Thread_Pool() {
+	wait();
+	{
+		std::lock_guard<std::mutex> guard(sleep_lock);
+		stopping = true;
+	}
+	work_available.notify_all();
+	for (auto&& thread : threads) {
+		thread.join();
+	}
+}
+
+void Thread_Pool::submit(std::function<void()> task) {
+	std::size_t index;
+	if (current_pool == this) {
+		index = current_worker;
+	}
+	else {
+		index = next_queue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+	}
+
+	unfinished.fetch_add(1);
+	{
+		std::lock_guard<std::mutex> guard(queues[index]->lock);
+		queues[index]->tasks.emplace_back(std::move(task));
+	}
+	// The task is there before a worker is woken for it. Taking the lock orders this
+	// against a worker checking queued before sleeping.
+	std::lock_guard<std::mutex> guard(sleep_lock);
+	queued.fetch_add(1);
+	work_available.notify_one();
+}
+
+void Thread_Pool::wait() {
+	std::unique_lock<std::mutex> guard(sleep_lock);
+	work_done.wait(guard, [this] { return unfinished.load() == 0; });
+}
+
+std::size_t Thread_Pool::size() {
+	return threads.size();
+}
+
+bool Thread_Pool::pop_task(std::size_t index, std::function<void()>& task) {
+	// Own deque first, newest task, it is the most likely to be warm in cache
+	{
+		auto&& own = *queues[index];
+		std::lock_guard<std::mutex> guard(own.lock);
+		if (!own.tasks.empty()) {
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			return true;
+		}
+	}
+
+	// Steal the oldest task from someone else
+	for (std::size_t offset = 1; offset < queues.size(); ++offset) {
+		auto&& victim = *queues[(index + offset) % queues.size()];
+		std::lock_guard<std::mutex> guard(victim.lock);
+		if (!victim.tasks.empty()) {
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void Thread_Pool::worker(std::size_t index) {
+	current_pool = this;
+	current_worker = index;
+
+	while (true) {
+		std::function<void()> task;
+		if (pop_task(index, task)) {
+			queued.fetch_sub(1);
+			task();
+
+			if (unfinished.fetch_sub(1) == 1) {
+				std::lock_guard<std::mutex> guard(sleep_lock);
+				work_done.notify_all();
+			}
+			continue;
+		}
+
+		std::unique_lock<std::mutex> guard(sleep_lock);
+		work_available.wait(guard, [this] { return stopping || queued.load() > 0; });
+		if (stopping && queued.load() <= 0) {
+			return;
+		}
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool. Every worker owns a task deque: it takes work from
+// the back of its own deque and steals from the front of the others when it
+// runs dry, so uneven tasks still keep every core busy.
+class Thread_Pool {
+  public:
+	explicit Thread_Pool(std::size_t thread_count = std::thread::hardware_concurrency());
+	~Thread_Pool();
+
+	Thread_Pool(const Thread_Pool&) = delete;
+	Thread_Pool& operator=(const Thread_Pool&) = delete;
+
+	void submit(std::function<void()> task);
+	void wait();
+	std::size_t size();
+
+  private:
+	struct worker_queue {
+		std::mutex lock;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	void worker(std::size_t index);
+	bool pop_task(std::size_t index, std::function<void()>& task);
+
+	std::vector<std::unique_ptr<worker_queue>> queues;
+	std::vector<std::thread> threads;
+
+	std::mutex sleep_lock;
+	std::condition_variable work_available;
+	std::condition_variable work_done;
+
+	std::atomic<std::size_t> next_queue{0};
+	// Tasks pushed and not taken yet, only used to decide whether to sleep. A worker can
+	// take a task before submit() counts it, so it goes below zero for a moment.
+	std::atomic<std::ptrdiff_t> queued{0};
+	std::atomic<std::size_t> unfinished{0};
+	bool stopping = false;
+};
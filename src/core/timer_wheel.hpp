@@ -0,0 +1,301 @@
+#pragma once
+
+#include "fixed_vector.hpp"
+
+#include <array>
+#include <cinttypes>
+#include <cstddef>
+#include <limits>
+
+// What every timer wheel hands out and fires, whatever its size
+namespace timer {
+	using timer_id = uint32_t;
+	constexpr timer_id no_timer = std::numeric_limits<timer_id>::max();
+
+	struct event {
+		uint32_t kind;
+		uint32_t target;
+	};
+}
+
+// Hierarchical timer wheel keyed on the tick number. Four levels of 256 slots cover
+// every 32 bit tick: a timer sits in the lowest level whose slot range still contains
+// its expiry and is moved down a level each time the level below wraps. Advancing a
+// tick only touches the timers that fire or cascade, never the ones still waiting.
+// Nodes live in a fixed array, so the wheel is trivially copyable.
+template <std::size_t Capacity>
+class Timer_Wheel {
+  public:
+	using timer_id = timer::timer_id;
+	using event = timer::event;
+	static constexpr timer_id no_timer = timer::no_timer;
+	// Timers that can be pending at once
+	static constexpr std::size_t capacity = Capacity;
+
+	// Holds every timer that can be pending, so advancing into an empty list never
+	// drops an event
+	using event_list = Fixed_Vector<event, Capacity>;
+
+	// Starts the wheel at the given tick, dropping every timer
+	void reset(uint32_t tick = 0) {
+		used = 0;
+		free_head = no_timer;
+		slots.fill(slot_list{});
+		current = tick;
+		active = 0;
+	}
+
+	// Schedules an event for the given tick, clamped to the next tick if it is earlier.
+	// Returns no_timer when every node is in use.
+	timer_id schedule(uint32_t expiry, event ev) {
+		timer_id id;
+		if (free_head != no_timer) {
+			id = free_head;
+			free_head = nodes[id].next;
+		}
+		else if (used < capacity) {
+			id = used++;
+		}
+		else {
+			return no_timer;
+		}
+
+		auto&& n = nodes[id];
+		n.expiry = expiry > current ? expiry : current + 1;
+		n.ev = ev;
+		insert(id);
+		active += 1;
+
+		return id;
+	}
+
+	void cancel(timer_id id) {
+		unlink(id);
+		nodes[id].next = free_head;
+		free_head = id;
+		active -= 1;
+	}
+
+	// Changes what an already scheduled event points at, for storage that moves entities
+	void retarget(timer_id id, uint32_t target) {
+		nodes[id].ev.target = target;
+	}
+
+	// Moves the wheel forward to tick and appends every event that expired on the way,
+	// in expiry order. Events for the same tick come out in the order they were scheduled.
+	void advance(uint32_t tick, event_list& fired) {
+		while (current != tick) {
+			current += 1;
+
+			// Refill the lower levels first when they wrap, highest level first so
+			// timers can fall through more than one level in the same tick
+			if ((current & (slot_count - 1)) == 0) {
+				std::size_t level = 1;
+				while (level < level_count - 1 &&
+				       ((current >> (level * level_bits)) & (slot_count - 1)) == 0) {
+					level += 1;
+				}
+				for (; level > 0; --level) {
+					cascade(level);
+				}
+			}
+
+			auto&& slot = slots[current & (slot_count - 1)];
+			while (slot.head != no_timer) {
+				auto id = slot.head;
+				fired.push_back(nodes[id].ev);
+				cancel(id);
+			}
+		}
+	}
+
+	uint32_t now() const {
+		return current;
+	}
+	std::size_t pending() const {
+		return static_cast<std::size_t>(active);
+	}
+
+	// Visits every member for saving and loading, see replay.cpp. Only pending timers
+	// are stored, slot by slot in firing order, and the free nodes in the order they
+	// will be handed out again. Loading rebuilds the slot lists from them, every timer
+	// lands where it was since where it sits only depends on its expiry and the tick.
+	template <class Stream>
+	void transfer(Stream& stream) {
+		if (Stream::loading) {
+			load(stream);
+		}
+		else {
+			save(stream);
+		}
+	}
+
+  private:
+	static constexpr std::size_t level_bits = 8;
+	static constexpr std::size_t slot_count = 1 << level_bits;
+	static constexpr std::size_t level_count = 4;
+
+	struct node {
+		uint32_t expiry;
+		event ev;
+		timer_id prev, next;
+		uint32_t slot;
+	};
+	struct slot_list {
+		timer_id head = no_timer;
+		timer_id tail = no_timer;
+	};
+
+	template <class Stream>
+	void save(Stream& stream) {
+		stream.value(current);
+		auto count = static_cast<uint32_t>(active);
+		stream.count(count, capacity);
+		for (auto&& slot : slots) {
+			for (auto id = slot.head; id != no_timer; id = nodes[id].next) {
+				stream.value(id);
+				stream.value(nodes[id].expiry);
+				stream.value(nodes[id].ev);
+			}
+		}
+		uint32_t free_count = used - count;
+		stream.count(free_count, capacity);
+		for (auto id = free_head; id != no_timer; id = nodes[id].next) {
+			stream.value(id);
+		}
+	}
+
+	template <class Stream>
+	void load(Stream& stream) {
+		uint32_t tick = 0;
+		stream.value(tick);
+		reset(tick);
+
+		std::array<bool, Capacity> seen = {};
+		// Ids are only ever handed out from 0 up, so the pending and free ones together
+		// are exactly [0, used)
+		auto take = [&](timer_id id, uint32_t total) {
+			if (id >= total || seen[id]) {
+				return false;
+			}
+			seen[id] = true;
+			return true;
+		};
+
+		uint32_t count = 0;
+		stream.count(count, capacity);
+		std::array<timer_id, Capacity> order;
+		for (uint32_t k = 0; k < count; ++k) {
+			timer_id id = no_timer;
+			node n = {};
+			stream.value(id);
+			stream.value(n.expiry);
+			stream.value(n.ev);
+			if (id >= capacity || n.expiry <= current) {
+				reset(tick);
+				stream.fail();
+				return;
+			}
+			nodes[id].expiry = n.expiry;
+			nodes[id].ev = n.ev;
+			order[k] = id;
+		}
+		uint32_t free_count = 0;
+		stream.count(free_count, capacity);
+		if (count + free_count > capacity) {
+			reset(tick);
+			stream.fail();
+			return;
+		}
+		used = count + free_count;
+		for (uint32_t k = 0; k < count; ++k) {
+			if (!take(order[k], used)) {
+				reset(tick);
+				stream.fail();
+				return;
+			}
+			insert(order[k]);
+		}
+		active = count;
+
+		timer_id* link = &free_head;
+		for (uint32_t k = 0; k < free_count; ++k) {
+			timer_id id = no_timer;
+			stream.value(id);
+			if (!take(id, used)) {
+				reset(tick);
+				stream.fail();
+				return;
+			}
+			*link = id;
+			link = &nodes[id].next;
+		}
+		*link = no_timer;
+	}
+
+	// The lowest level whose shared prefix with the current tick covers the expiry
+	void insert(timer_id id) {
+		auto&& n = nodes[id];
+		std::size_t level = 0;
+		while (level < level_count - 1 && (n.expiry >> ((level + 1) * level_bits)) !=
+		                                      (current >> ((level + 1) * level_bits))) {
+			level += 1;
+		}
+		n.slot = static_cast<uint32_t>(level * slot_count +
+		                               ((n.expiry >> (level * level_bits)) & (slot_count - 1)));
+
+		auto&& slot = slots[n.slot];
+		n.prev = slot.tail;
+		n.next = no_timer;
+		if (slot.tail != no_timer) {
+			nodes[slot.tail].next = id;
+		}
+		else {
+			slot.head = id;
+		}
+		slot.tail = id;
+	}
+
+	void unlink(timer_id id) {
+		auto&& n = nodes[id];
+		auto&& slot = slots[n.slot];
+		if (n.prev != no_timer) {
+			nodes[n.prev].next = n.next;
+		}
+		else {
+			slot.head = n.next;
+		}
+		if (n.next != no_timer) {
+			nodes[n.next].prev = n.prev;
+		}
+		else {
+			slot.tail = n.prev;
+		}
+	}
+
+	// Re-inserts every timer in the level's current slot, which now lands them lower down
+	void cascade(std::size_t level) {
+		auto index = level * slot_count + ((current >> (level * level_bits)) & (slot_count - 1));
+		auto id = slots[index].head;
+		slots[index] = slot_list{};
+		while (id != no_timer) {
+			auto next = nodes[id].next;
+			insert(id);
+			id = next;
+		}
+	}
+
+	std::array<node, capacity> nodes;
+	std::array<slot_list, slot_count * level_count> slots;
+	// Nodes [0, used) have been handed out at some point, the free ones among them are
+	// chained through next starting at free_head
+	uint32_t used = 0;
+	timer_id free_head = no_timer;
+	uint32_t current = 0;
+	uint64_t active = 0;
+};
+
+template <std::size_t Capacity>
+constexpr typename Timer_Wheel<Capacity>::timer_id Timer_Wheel<Capacity>::no_timer;
+template <std::size_t Capacity>
+constexpr std::size_t Timer_Wheel<Capacity>::capacity;
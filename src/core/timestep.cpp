@@ -0,0 +1,40 @@
+#include "timestep.hpp"
+
+void Fixed_Timestep::advance(float frame_time) {
+	accumulator += static_cast<double>(frame_time);
+	ticks_this_frame = 0;
+}
+
+bool Fixed_Timestep::tick() {
+	if (accumulator < step) {
+		return false;
+	}
+
+	// Drop the backlog after a long hitch instead of trying to catch up with it,
+	// otherwise every following frame gets slower.
+	if (ticks_this_frame >= max_ticks_per_frame) {
+		accumulator = 0;
+		return false;
+	}
+
+	accumulator -= step;
+	ticks_this_frame += 1;
+	tick_number += 1;
+	return true;
+}
+
+float Fixed_Timestep::get_step() {
+	return static_cast<float>(step);
+}
+
+float Fixed_Timestep::get_tick_rate() {
+	return tick_rate;
+}
+
+float Fixed_Timestep::get_alpha() {
+	return static_cast<float>(accumulator / step);
+}
+
+uint64_t Fixed_Timestep::get_tick_number() {
+	return tick_number;
+}
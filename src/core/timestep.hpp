@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+
+// Accumulates real frame time and hands it out as fixed simulation ticks. The
+// leftover fraction of a tick is exposed as an interpolation factor for rendering.
+class Fixed_Timestep {
+  public:
+	Fixed_Timestep(float rate = 120.0f, std::size_t max_ticks = 8)
+	    : tick_rate(rate), step(1.0 / static_cast<double>(rate)), max_ticks_per_frame(max_ticks){};
+
+	void advance(float frame_time);
+	bool tick();
+
+	float get_step();
+	float get_tick_rate();
+	float get_alpha();
+	uint64_t get_tick_number();
+
+  private:
+	float tick_rate;
+	double step;
+	double accumulator = 0;
+
+	std::size_t max_ticks_per_frame;
+	std::size_t ticks_this_frame = 0;
+
+	uint64_t tick_number = 0;
+};
@@ -0,0 +1,127 @@
+#include "udp_socket.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+using socket_length = int;
+static const uintptr_t bad_socket = INVALID_SOCKET;
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+using socket_length = socklen_t;
+static const int bad_socket = -1;
+#endif
+
+template <class Handle>
+static void close_socket(Handle handle) {
+#ifdef _WIN32
+	closesocket(handle);
+#else
+	close(handle);
+#endif
+}
+
+static sockaddr_in to_sockaddr(const Udp_Socket::address& addr) {
+	sockaddr_in sa;
+	std::memset(&sa, 0, sizeof(sa));
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = htonl(addr.host);
+	sa.sin_port = htons(addr.port);
+	return sa;
+}
+
+bool Udp_Socket::parse_address(const std::string& text, address& out) {
+	unsigned a, b, c, d, p;
+	char tail;
+	if (std::sscanf(text.c_str(), "%u.%u.%u.%u:%u%c", &a, &b, &c, &d, &p, &tail) != 5 ||
+	    a > 255 || b > 255 || c > 255 || d > 255 || p > 65535) {
+		return false;
+	}
+	out.host = (a << 24) | (b << 16) | (c << 8) | d;
+	out.port = static_cast<uint16_t>(p);
+	return true;
+}
+
+Udp_Socket::address Udp_Socket::loopback(uint16_t port) {
+	address addr;
+	addr.host = 0x7F000001;
+	addr.port = port;
+	return addr;
+}
+
+Udp_Socket::Udp_Socket(uint16_t bind_port) {
+#ifdef _WIN32
+	WSADATA wsa;
+	WSAStartup(MAKEWORD(2, 2), &wsa);
+#endif
+	handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (handle == bad_socket) {
+		return;
+	}
+
+	sockaddr_in sa;
+	std::memset(&sa, 0, sizeof(sa));
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = htonl(INADDR_ANY);
+	sa.sin_port = htons(bind_port);
+	socket_length length = sizeof(sa);
+	if (bind(handle, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) != 0 ||
+	    getsockname(handle, reinterpret_cast<sockaddr*>(&sa), &length) != 0) {
+		close_socket(handle);
+		handle = bad_socket;
+		return;
+	}
+	port = ntohs(sa.sin_port);
+
+#ifdef _WIN32
+	u_long non_blocking = 1;
+	ioctlsocket(handle, FIONBIO, &non_blocking);
+#else
+	fcntl(handle, F_SETFL, fcntl(handle, F_GETFL, 0) | O_NONBLOCK);
+#endif
+}
+
+Udp_Socket::~Udp_Socket() {
+	if (handle != bad_socket) {
+		close_socket(handle);
+	}
+#ifdef _WIN32
+	WSACleanup();
+#endif
+}
+
+bool Udp_Socket::is_open() const {
+	return handle != bad_socket;
+}
+
+bool Udp_Socket::send(const address& to, const void* data, std::size_t size) {
+	if (!is_open()) {
+		return false;
+	}
+	auto sa = to_sockaddr(to);
+	auto sent = sendto(handle, static_cast<const char*>(data), static_cast<int>(size), 0,
+	                   reinterpret_cast<const sockaddr*>(&sa), sizeof(sa));
+	return sent == static_cast<decltype(sent)>(size);
+}
+
+std::size_t Udp_Socket::receive(address& from, void* buffer, std::size_t capacity) {
+	if (!is_open()) {
+		return 0;
+	}
+	sockaddr_in sa;
+	socket_length length = sizeof(sa);
+	auto received = recvfrom(handle, static_cast<char*>(buffer), static_cast<int>(capacity), 0,
+	                         reinterpret_cast<sockaddr*>(&sa), &length);
+	if (received <= 0) {
+		return 0;
+	}
+	from.host = ntohl(sa.sin_addr.s_addr);
+	from.port = ntohs(sa.sin_port);
+	return static_cast<std::size_t>(received);
+}
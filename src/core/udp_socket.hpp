@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <string>
+
+// Non-blocking IPv4 UDP socket, just enough for peer to peer input exchange
+class Udp_Socket {
+  public:
+	struct address {
+		// Host byte order
+		uint32_t host = 0;
+		uint16_t port = 0;
+	};
+	// "a.b.c.d:port", false if it isn't one
+	static bool parse_address(const std::string& text, address& out);
+	static address loopback(uint16_t port);
+
+	// Port 0 picks a free one, see get_port
+	explicit Udp_Socket(uint16_t port = 0);
+	~Udp_Socket();
+
+	Udp_Socket(const Udp_Socket&) = delete;
+	Udp_Socket& operator=(const Udp_Socket&) = delete;
+
+	bool is_open() const;
+	uint16_t get_port() const {
+		return port;
+	}
+
+	bool send(const address& to, const void* data, std::size_t size);
+	// Size of the next waiting datagram, copied into buffer, or 0 when nothing is waiting
+	std::size_t receive(address& from, void* buffer, std::size_t capacity);
+
+  private:
+#ifdef _WIN32
+	using handle_type = uintptr_t;
+#else
+	using handle_type = int;
+#endif
+	handle_type handle;
+	uint16_t port = 0;
+};
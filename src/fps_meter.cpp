@@ -1,11 +1,25 @@
 #include "fps_meter.hpp"
+#include "gl_state.hpp"
+#include "render.hpp"
+#include "stream_buffer.hpp"
 #include <SDL2/SDL.h>
 #include <algorithm>
 #include <iostream>
 #include <utility>
 
 void FPS_Meter::frame(size_t lightcount) {
-	last_frame_time = std::exchange(frame_time, static_cast<float>(SDL_GetTicks()) / 1000.f);
+	// SDL_GetTicks only has millisecond resolution, which is too coarse to feed a
+	// fixed timestep accumulator at high frame rates.
+	uint64_t counter = SDL_GetPerformanceCounter();
+	auto frequency = static_cast<double>(SDL_GetPerformanceFrequency());
+	if (start_counter == 0) {
+		start_counter = last_counter = counter;
+	}
+	delta_time = static_cast<float>(static_cast<double>(counter - last_counter) / frequency);
+	last_counter = counter;
+
+	last_frame_time = std::exchange(
+	    frame_time, static_cast<float>(static_cast<double>(counter - start_counter) / frequency));
 	frame_times.push_back(frame_time);
 	frame_number += 1;
 	fps_ready = false;
@@ -26,7 +40,7 @@ float FPS_Meter::get_time() {
 }
 
 float FPS_Meter::get_delta_time() {
-	return frame_time - last_frame_time;
+	return delta_time;
 }
 
 void FPS_Meter::update_fps(size_t lightcount) {
@@ -39,6 +53,17 @@ void FPS_Meter::update_fps(size_t lightcount) {
 		if (print_fps && frame_time - last_print_time >= 1) {
 			std::cout << "FPS: " << fps << " - " << frame_times.size() << " - " << timeperlight << "ms/light"
 			          << std::endl;
+			auto&& stream = stream_buffer::get_stats();
+			std::cout << "Stream buffer: " << stream.bytes << " bytes - " << stream.stalls
+			          << " stalls - " << stream.grows << " grows"
+			          << (stream.persistent ? "" : " - orphaned") << std::endl;
+			auto&& state = gl_state::get_stats();
+			std::cout << "GL state: " << state.issued << " issued - " << state.skipped
+			          << " skipped" << std::endl;
+			auto&& queue = render::get_queue_stats();
+			std::cout << "Draw queue: " << queue.items << " items - " << queue.draw_calls
+			          << " draw calls - " << queue.binds << " binds - " << queue.binds_avoided
+			          << " binds avoided" << std::endl;
 			last_print_time = frame_time;
 		}
 	};
@@ -27,6 +27,10 @@ class FPS_Meter {
 
 	float frame_time      = 0;
 	float last_frame_time = 0;
+	float delta_time      = 0;
+
+	uint64_t start_counter = 0;
+	uint64_t last_counter  = 0;
 
 	float last_print_time = 0;
 };
@@ -1,17 +1,13 @@
 #include "gamegrid.hpp"
-#include "controller.hpp"
 #include "image.hpp"
-#include "player.hpp"
 #include "render.hpp"
 
-#include <algorithm>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
-#include <iostream>
-#include <random>
+#include <map>
 #include <tuple>
-
-gamegrid::GameGrid gamegrid::gamegrid;
+#include <utility>
+#include <vector>
 
 ObjFile gamegrid::spikeycube;
 ObjFile gamegrid::bomb;
@@ -25,12 +21,48 @@ static GLuint spikeycube_tex;
 static GLuint bomb_tex;
 static GLuint bullet_tex;
 
-void gamegrid::initialize(std::size_t width, std::size_t height) {
-	gamegrid.width = width;
-	gamegrid.height = height;
-	gamegrid.state.reserve(width * height);
-	gamegrid.state.resize(width * height, State{StateType::empty});
+// Floor meshes are built per chunk extent, so there are at most four of them (full,
+// right edge, bottom edge, corner) whatever the size of the arena
+struct floor_mesh {
+	GLuint vao, vbo;
+	std::size_t vertex_count;
+};
+static std::map<std::pair<std::size_t, std::size_t>, floor_mesh> floor_meshes;
+static GLuint floor_tex;
+
+// Left half of the floor texture is tile, right half is the gaps between them
+static void add_quad(std::vector<Vertex>& vertices, float x0, float z0, float x1, float z1, float y,
+                     float u) {
+	Vertex a{x0, y, z0, u, 0.5f, 0, 1, 0};
+	Vertex b{x0, y, z1, u, 0.5f, 0, 1, 0};
+	Vertex c{x1, y, z0, u, 0.5f, 0, 1, 0};
+	Vertex d{x1, y, z1, u, 0.5f, 0, 1, 0};
+	vertices.insert(vertices.end(), {a, b, c, c, b, d});
+}
+
+static const floor_mesh& get_floor_mesh(std::size_t width, std::size_t height) {
+	auto found = floor_meshes.find(std::make_pair(width, height));
+	if (found != floor_meshes.end()) {
+		return found->second;
+	}
+
+	std::vector<Vertex> vertices;
+	vertices.reserve((width * height + 1) * 6);
+	add_quad(vertices, -0.5f, -0.5f, float(width) - 0.5f, float(height) - 0.5f, -0.02f, 0.75f);
+	for (std::size_t y = 0; y < height; ++y) {
+		for (std::size_t x = 0; x < width; ++x) {
+			add_quad(vertices, float(x) - 0.45f, float(y) - 0.45f, float(x) + 0.45f,
+			         float(y) + 0.45f, 0.01f, 0.25f);
+		}
+	}
 
+	floor_mesh mesh;
+	std::tie(mesh.vao, mesh.vbo) = render::upload_vertices(vertices);
+	mesh.vertex_count = vertices.size();
+	return floor_meshes.emplace(std::make_pair(width, height), mesh).first->second;
+}
+
+void gamegrid::initialize_render() {
 	spikeycube = parse_obj_file("objects/spikeycube.obj");
 	bomb = parse_obj_file("objects/bomb.obj");
 	bullet = parse_obj_file("objects/bullet.obj");
@@ -48,63 +80,59 @@ void gamegrid::initialize(std::size_t width, std::size_t height) {
 	auto spikes_raw = image::create_ogl_image("textures/spikes.png");
 	spikeycube_tex = render::upload_texture(spikes_raw);
 
-	regenerate();
+	image::image floor_raw;
+	floor_raw.width = 2;
+	floor_raw.height = 1;
+	floor_raw.data.push_back(image::pixel{255, 255, 255, 255});
+	floor_raw.data.push_back(image::pixel{90, 90, 90, 255});
+	floor_tex = render::upload_texture(floor_raw);
 }
 
-void gamegrid::read_controls(const typename control::movement_report_type& rt) {
-	if (std::any_of(rt.begin(), rt.end(),
-	                [](auto controller) { return controller.keys[6] && controller.active; })) {
-		regenerate();
-		players::respawn(0);
-		players::respawn(1);
-		players::respawn(2);
-		players::respawn(3);
-	}
-}
-
-void gamegrid::regenerate() {
-	static std::mt19937 prng{std::random_device{}()};
-
-	std::uniform_int_distribution<int> gg_uid(0, 3);
-	for (std::size_t x = 1; x < gamegrid::gamegrid.width - 1; ++x) {
-		for (std::size_t y = 1; y < gamegrid::gamegrid.height - 1; ++y) {
-			gamegrid::gamegrid.state[y * gamegrid::gamegrid.width + x].type =
-			    static_cast<gamegrid::StateType>(gg_uid(prng));
-		}
-	}
-}
-
-void gamegrid::render(GLuint world_matrix_uniform) {
-	for (std::size_t i = 0; i < gamegrid.state.size(); ++i) {
-		if (gamegrid.state[i].type == StateType::empty) {
-			continue;
-		}
-
-		auto x = float(i % gamegrid.width);
-		auto y = float(i / gamegrid.width);
-
-		glm::mat4 world =
-		    glm::translate(glm::mat4{}, glm::vec3(x - (float(gamegrid.width) - 1.0f) / 2.0f, 0.5,
-		                                          y - (float(gamegrid.height) - 1.0f) / 2.0f));
-
-		switch (gamegrid.state[i].type) {
-			case StateType::empty:
-				break;
-			case StateType::powerup_ammo:
-				render::render_object(bullet_vao, bullet_vbo, bullet.objects[0].vertices.size(),
-				                      bullet_tex, world_matrix_uniform, world);
-				break;
-			case StateType::powerup_bomb:
-				render::render_object(bomb_vao, bomb_vbo, bomb.objects[0].vertices.size(), bomb_tex,
-				                      world_matrix_uniform, world);
-				break;
-			case StateType::trap:
-				render::render_object(spikeycube_vao, spikeycube_vbo,
-				                      spikeycube.objects[0].vertices.size(), spikeycube_tex,
-				                      world_matrix_uniform, world);
-				break;
-			default:
-				break;
+void gamegrid::render(const game::World& world, const glm::mat4& view_projection) {
+	auto&& gamegrid = world.grid;
+	auto offset = (glm::vec2{gamegrid.width, gamegrid.height} - 1.0f) / 2.0f;
+	auto frustum = render::extract_frustum(view_projection);
+
+	auto place = [&](std::size_t x, std::size_t y) {
+		return render::grid_transform(gamegrid, glm::vec2(x, y));
+	};
+
+	// Chunks outside the frustum are skipped whole, so the cost follows what is on
+	// screen rather than the size of the arena
+	for (std::size_t cy = 0; cy < gamegrid.chunks_y; ++cy) {
+		for (std::size_t cx = 0; cx < gamegrid.chunks_x; ++cx) {
+			auto first_x = cx * chunk_size;
+			auto first_y = cy * chunk_size;
+			auto chunk_width = std::min(chunk_size, gamegrid.width - first_x);
+			auto chunk_height = std::min(chunk_size, gamegrid.height - first_y);
+
+			glm::vec3 min(float(first_x) - offset.x - 0.5f, -0.1f,
+			              float(first_y) - offset.y - 0.5f);
+			glm::vec3 max = min + glm::vec3(chunk_width, 1.5f, chunk_height);
+			if (!render::intersects(frustum, min, max)) {
+				continue;
+			}
+
+			auto&& floor = get_floor_mesh(chunk_width, chunk_height);
+			auto chunk_origin =
+			    glm::vec3(float(first_x) - offset.x, 0.0f, float(first_y) - offset.y);
+			render::submit(floor.vao, floor.vertex_count, floor_tex,
+			               glm::translate(glm::mat4{}, chunk_origin));
+
+			for_each_in_chunk(gamegrid, StateType::powerup_ammo, cx, cy,
+			                  [&](std::size_t x, std::size_t y) {
+				                  render::submit(bullet_vao, bullet.objects[0].vertices.size(),
+				                                 bullet_tex, place(x, y));
+				              });
+			for_each_in_chunk(gamegrid, StateType::powerup_bomb, cx, cy,
+			                  [&](std::size_t x, std::size_t y) {
+				                  render::submit(bomb_vao, bomb.objects[0].vertices.size(),
+				                                 bomb_tex, place(x, y));
+				              });
+			for_each_in_chunk(gamegrid, StateType::trap, cx, cy, [&](std::size_t x, std::size_t y) {
+				render::submit(spikeycube_vao, spikeycube.objects[0].vertices.size(),
+				               spikeycube_tex, place(x, y));
+			});
 		}
 	}
 }
@@ -1,32 +1,17 @@
 #pragma once
 
-#include "controller.hpp"
+#include "core/game.hpp"
+#include "core/gamegrid.hpp"
 #include "objparser.hpp"
 #include <GL/glew.h>
-#include <vector>
+#include <glm/glm.hpp>
 
 namespace gamegrid {
-	enum class StateType { empty = 0, powerup_ammo = 1, powerup_bomb = 2, trap = 3 };
-
-	struct State {
-		StateType type;
-		int data = 0;
-	};
-
-	struct GameGrid {
-		std::vector<State> state;
-		std::size_t width;
-		std::size_t height;
-	};
-
-	extern GameGrid gamegrid;
-
 	extern ObjFile spikeycube;
 	extern ObjFile bomb;
 	extern ObjFile bullet;
 
-	void initialize(std::size_t width, std::size_t height);
-	void render(GLuint world_matrix_uniform);
-	void regenerate();
-	void read_controls(const control::movement_report_type& rt);
-}
\ No newline at end of file
+	void initialize_render();
+	// Queues the floor and the contents of every chunk inside the view frustum
+	void render(const game::World& world, const glm::mat4& view_projection);
+}
@@ -0,0 +1,140 @@
+#include "gl_state.hpp"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+// Names no object has, for state that isn't known
+static constexpr GLuint unknown = 0xFFFFFFFF;
+static constexpr GLenum unknown_enum = 0xFFFFFFFF;
+
+static GLuint program = unknown;
+static GLuint read_framebuffer = unknown;
+static GLuint draw_framebuffer = unknown;
+static GLuint vertex_array = unknown;
+static GLuint active_unit = unknown;
+static std::array<GLuint, gl_state::texture_units> unknown_textures() {
+	std::array<GLuint, gl_state::texture_units> all;
+	all.fill(unknown);
+	return all;
+}
+static std::array<GLuint, gl_state::texture_units> textures = unknown_textures();
+static GLenum depth_function = unknown_enum;
+// 0 and 1 for false and true, -1 for not known
+static int depth_write = -1;
+static std::array<std::pair<GLenum, int>, 8> capabilities;
+static std::size_t capability_count = 0;
+
+static gl_state::stats counting, last_frame;
+
+// Counts the call and whether it is needed, updating the remembered value if so
+template <class T>
+static bool change(T& current, T wanted) {
+	if (current == wanted) {
+		counting.skipped += 1;
+		return false;
+	}
+	current = wanted;
+	counting.issued += 1;
+	return true;
+}
+
+void gl_state::use_program(GLuint wanted) {
+	if (change(program, wanted)) {
+		glUseProgram(wanted);
+	}
+}
+
+void gl_state::bind_framebuffer(GLenum target, GLuint framebuffer) {
+	if (target == GL_READ_FRAMEBUFFER) {
+		if (change(read_framebuffer, framebuffer)) {
+			glBindFramebuffer(target, framebuffer);
+		}
+		return;
+	}
+	if (target == GL_DRAW_FRAMEBUFFER) {
+		if (change(draw_framebuffer, framebuffer)) {
+			glBindFramebuffer(target, framebuffer);
+		}
+		return;
+	}
+	if (read_framebuffer == framebuffer && draw_framebuffer == framebuffer) {
+		counting.skipped += 1;
+		return;
+	}
+	read_framebuffer = framebuffer;
+	draw_framebuffer = framebuffer;
+	counting.issued += 1;
+	glBindFramebuffer(target, framebuffer);
+}
+
+void gl_state::bind_vertex_array(GLuint vao) {
+	if (change(vertex_array, vao)) {
+		glBindVertexArray(vao);
+	}
+}
+
+void gl_state::bind_texture(GLuint unit, GLuint texture) {
+	if (change(active_unit, unit)) {
+		glActiveTexture(GL_TEXTURE0 + unit);
+	}
+	if (unit >= textures.size()) {
+		counting.issued += 1;
+		glBindTexture(GL_TEXTURE_2D, texture);
+		return;
+	}
+	if (change(textures[unit], texture)) {
+		glBindTexture(GL_TEXTURE_2D, texture);
+	}
+}
+
+void gl_state::depth_func(GLenum func) {
+	if (change(depth_function, func)) {
+		glDepthFunc(func);
+	}
+}
+
+void gl_state::depth_mask(GLboolean mask) {
+	if (change(depth_write, mask ? 1 : 0)) {
+		glDepthMask(mask);
+	}
+}
+
+void gl_state::set_enabled(GLenum capability, bool enabled) {
+	auto end = capabilities.begin() + static_cast<std::ptrdiff_t>(capability_count);
+	auto found = std::find_if(capabilities.begin(), end,
+	                          [&](auto&& c) { return c.first == capability; });
+	if (found == end) {
+		if (capability_count == capabilities.size()) {
+			counting.issued += 1;
+			enabled ? glEnable(capability) : glDisable(capability);
+			return;
+		}
+		*found = std::make_pair(capability, -1);
+		capability_count += 1;
+	}
+	if (change(found->second, enabled ? 1 : 0)) {
+		enabled ? glEnable(capability) : glDisable(capability);
+	}
+}
+
+void gl_state::invalidate() {
+	program = unknown;
+	read_framebuffer = unknown;
+	draw_framebuffer = unknown;
+	vertex_array = unknown;
+	active_unit = unknown;
+	textures.fill(unknown);
+	depth_function = unknown_enum;
+	depth_write = -1;
+	capability_count = 0;
+}
+
+void gl_state::end_frame() {
+	last_frame = counting;
+	counting = stats{};
+}
+
+const gl_state::stats& gl_state::get_stats() {
+	return last_frame;
+}
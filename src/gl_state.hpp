@@ -0,0 +1,33 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <cstddef>
+
+// Remembers the GL state set through it and drops calls that would set what is already
+// set. Everything drawn each frame goes through here, code that changes the same state
+// behind its back must call invalidate() afterwards.
+namespace gl_state {
+	// Texture units tracked, binds to units past these are always made
+	constexpr std::size_t texture_units = 16;
+
+	void use_program(GLuint program);
+	// GL_FRAMEBUFFER binds both the read and draw framebuffers
+	void bind_framebuffer(GLenum target, GLuint framebuffer);
+	void bind_vertex_array(GLuint vao);
+	// Makes unit the active unit and binds a 2D texture to it
+	void bind_texture(GLuint unit, GLuint texture);
+	void depth_func(GLenum func);
+	void depth_mask(GLboolean mask);
+	void set_enabled(GLenum capability, bool enabled);
+
+	// Forgets everything, the next call of each kind is made whatever it sets
+	void invalidate();
+
+	struct stats {
+		std::size_t issued = 0;
+		std::size_t skipped = 0;
+	};
+	// Closes the frame's counts, get_stats() returns the last closed frame
+	void end_frame();
+	const stats& get_stats();
+}
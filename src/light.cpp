@@ -1,5 +1,7 @@
 #include "light.hpp"
+#include "gl_state.hpp"
 #include "objparser.hpp"
+#include "stream_buffer.hpp"
 
 #include <GL/glew.h>
 
@@ -21,9 +23,6 @@ namespace lights {
 
 	GLuint Light_VAO, Light_VBO;
 	GLuint LightCircle_VBO;
-	GLuint LightTransform_VBO;
-	GLuint LightColor_VBO;
-	GLuint LightPosition_VBO;
 
 	std::size_t add(glm::vec3 color, glm::vec3 position) {
 		constexpr float constant = 1.0f;
@@ -65,38 +64,14 @@ namespace lights {
 
 	void initialize() {
 		glGenVertexArrays(1, &Light_VAO);
-		glBindVertexArray(Light_VAO);
-
-		glGenBuffers(1, &LightTransform_VBO);
-		glBindBuffer(GL_ARRAY_BUFFER, LightTransform_VBO);
-		glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
-		                      reinterpret_cast<GLvoid*>(0 * sizeof(GLfloat)));
-		glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
-		                      reinterpret_cast<GLvoid*>(4 * sizeof(GLfloat)));
-		glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
-		                      reinterpret_cast<GLvoid*>(8 * sizeof(GLfloat)));
-		glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
-		                      reinterpret_cast<GLvoid*>(12 * sizeof(GLfloat)));
-		glEnableVertexAttribArray(2);
-		glEnableVertexAttribArray(3);
-		glEnableVertexAttribArray(4);
-		glEnableVertexAttribArray(5);
-		glVertexAttribDivisor(2, 1);
-		glVertexAttribDivisor(3, 1);
-		glVertexAttribDivisor(4, 1);
-		glVertexAttribDivisor(5, 1);
-
-		glGenBuffers(1, &LightColor_VBO);
-		glBindBuffer(GL_ARRAY_BUFFER, LightColor_VBO);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), NULL);
-		glEnableVertexAttribArray(1);
-		glVertexAttribDivisor(1, 1);
-
-		glGenBuffers(1, &LightPosition_VBO);
-		glBindBuffer(GL_ARRAY_BUFFER, LightPosition_VBO);
-		glVertexAttribPointer(6, 3, GL_FLOAT, GL_FALSE, sizeof(LightData), NULL);
-		glEnableVertexAttribArray(6);
-		glVertexAttribDivisor(6, 1);
+		gl_state::bind_vertex_array(Light_VAO);
+
+		// Transforms in 2 to 5, color in 1 and position in 6, all streamed in each frame by
+		// updatetransforms()
+		for (GLuint attrib = 1; attrib <= 6; ++attrib) {
+			glEnableVertexAttribArray(attrib);
+			glVertexAttribDivisor(attrib, 1);
+		}
 
 		glGenBuffers(1, &LightCircle_VBO);
 		glBindBuffer(GL_ARRAY_BUFFER, LightCircle_VBO);
@@ -104,7 +79,7 @@ namespace lights {
 		             circlefile.objects[0].vertices.data(), GL_STATIC_DRAW);
 		glVertexAttribPointer(7, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), NULL);
 
-		glBindVertexArray(0);
+		gl_state::bind_vertex_array(0);
 	}
 
 	void updatetransforms() {
@@ -118,17 +93,25 @@ namespace lights {
 			lighteffectworldmatrix[i] = translate;
 		}
 
-		glBindVertexArray(Light_VAO);
-		glBindBuffer(GL_ARRAY_BUFFER, LightTransform_VBO);
-		glBufferData(GL_ARRAY_BUFFER, lightcount * sizeof(glm::mat4), lighteffectworldmatrix.data(),
-		             GL_STREAM_DRAW);
+		auto transforms =
+		    stream_buffer::push(lighteffectworldmatrix.data(), lightcount * sizeof(glm::mat4));
+		auto positions = stream_buffer::push(lightdata.data(), lightcount * sizeof(LightData));
+		auto colors = stream_buffer::push(lightcolor.data(), lightcount * sizeof(glm::vec3));
+
+		gl_state::bind_vertex_array(Light_VAO);
+		glBindBuffer(GL_ARRAY_BUFFER, transforms.buffer);
+		for (GLuint c = 0; c < 4; ++c) {
+			auto offset = transforms.offset + c * sizeof(glm::vec4);
+			glVertexAttribPointer(2 + c, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+			                      reinterpret_cast<GLvoid*>(offset));
+		}
 
-		glBindBuffer(GL_ARRAY_BUFFER, LightPosition_VBO);
-		glBufferData(GL_ARRAY_BUFFER, lightcount * sizeof(LightData), lightdata.data(),
-		             GL_STREAM_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, positions.buffer);
+		glVertexAttribPointer(6, 3, GL_FLOAT, GL_FALSE, sizeof(LightData),
+		                      reinterpret_cast<GLvoid*>(positions.offset));
 
-		glBindBuffer(GL_ARRAY_BUFFER, LightColor_VBO);
-		glBufferData(GL_ARRAY_BUFFER, lightcount * sizeof(glm::vec3), lightcolor.data(),
-		             GL_STREAM_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, colors.buffer);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3),
+		                      reinterpret_cast<GLvoid*>(colors.offset));
 	}
 }
\ No newline at end of file
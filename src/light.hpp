@@ -23,9 +23,6 @@ namespace lights {
 
 	extern GLuint Light_VAO, Light_VBO;
 	extern GLuint LightCircle_VBO;
-	extern GLuint LightTransform_VBO;
-	extern GLuint LightColor_VBO;
-	extern GLuint LightPosition_VBO;
 
 	extern ObjFile circlefile;
 	extern std::size_t lightcount;
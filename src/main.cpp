@@ -14,6 +14,7 @@
 #include <memory>
 #include <random>
 #include <sstream>
+#include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -24,6 +25,7 @@
 #include "controller.hpp"
 #include "fps_meter.hpp"
 #include "gamegrid.hpp"
+#include "gl_state.hpp"
 #include "image.hpp"
 #include "light.hpp"
 #include "objparser.hpp"
@@ -31,8 +33,16 @@
 #include "render.hpp"
 #include "sdlmanager.hpp"
 #include "shader.hpp"
+#include "stream_buffer.hpp"
 #include "ui.hpp"
 
+#include "core/bot.hpp"
+#include "core/game.hpp"
+#include "core/net_client.hpp"
+#include "core/rollback.hpp"
+#include "core/timestep.hpp"
+#include "core/udp_socket.hpp"
+
 #ifdef _WIN32
 #define APIENTRY __stdcall
 #else
@@ -62,15 +72,67 @@ auto lerp(T1 a, T2 b, T3 f) {
 }
 
 int main(int argc, char** argv) {
-	(void) argc;
-	(void) argv;
+	float tick_rate = 120.0f;
+	std::size_t grid_width = 11, grid_height = 11;
+	uint32_t seed = std::random_device{}();
+	// Slots played locally, by controllers or bots
+	std::size_t player_count = 4;
+	// Netplay: the slot played here and the address of every slot's peer, own one included
+	Rollback_Session::settings net;
+	std::vector<Udp_Socket::address> peer_addresses;
+	// Dedicated server to join instead, and the match on it
+	Udp_Socket::address server_address;
+	uint32_t server_match = net::any_match;
+	for (int i = 1; i + 1 < argc; ++i) {
+		std::string arg = argv[i];
+		std::string value = argv[i + 1];
+		if (arg == "--tick-rate") {
+			tick_rate = std::max(1.0f, std::stof(value));
+		}
+		else if (arg == "--size") {
+			grid_width = std::stoul(value);
+			auto split = value.find('x');
+			grid_height =
+			    split == std::string::npos ? grid_width : std::stoul(value.substr(split + 1));
+		}
+		else if (arg == "--seed") {
+			seed = static_cast<uint32_t>(std::stoul(value));
+		}
+		else if (arg == "--players") {
+			player_count = std::min(std::max<std::size_t>(std::stoul(value), 1),
+			                        control::max_players);
+		}
+		else if (arg == "--netplay") {
+			net.local_slot = std::stoul(value);
+		}
+		else if (arg == "--peers") {
+			std::istringstream list(value);
+			std::string entry;
+			while (std::getline(list, entry, ',')) {
+				Udp_Socket::address addr;
+				if (!Udp_Socket::parse_address(entry, addr)) {
+					std::cerr << "Bad peer address " << entry << '\n';
+					return 1;
+				}
+				peer_addresses.push_back(addr);
+			}
+		}
+		else if (arg == "--connect") {
+			if (!Udp_Socket::parse_address(value, server_address)) {
+				std::cerr << "Bad server address " << value << '\n';
+				return 1;
+			}
+		}
+		else if (arg == "--match") {
+			server_match = static_cast<uint32_t>(std::stoul(value));
+		}
+	}
 
 	//////////////////////////
 	// Parse an object file //
 	//////////////////////////
 
 	auto file = parse_obj_file("objects/teapot.obj");
-	auto worldfile = parse_obj_file("objects/grid.obj");
 
 	///////////////
 	// SDL Setup //
@@ -78,8 +140,8 @@ int main(int argc, char** argv) {
 
 	SDL_Manager sdlm;
 
-	glEnable(GL_DEPTH_TEST);
-	glEnable(GL_CULL_FACE);
+	gl_state::set_enabled(GL_DEPTH_TEST, true);
+	gl_state::set_enabled(GL_CULL_FACE, true);
 	glCullFace(GL_BACK);
 	glFrontFace(GL_CCW);
 
@@ -113,14 +175,8 @@ int main(int argc, char** argv) {
 	geometrypass.link();
 	geometrypass.use();
 
-	auto uGeoWorld = geometrypass.getUniform("world", Shader::MANDITORY);
-	auto uGeoView = geometrypass.getUniform("view", Shader::MANDITORY);
-	auto uGeoProjection = geometrypass.getUniform("projection", Shader::MANDITORY);
 	glUniform1i(geometrypass.getUniform("tex"), 0);
 
-	auto world_world =
-	    glm::scale(glm::translate(glm::mat4(), glm::vec3(0, 0, 0)), glm::vec3(1, 1, 1));
-	auto monkey_world = glm::translate(glm::mat4(), glm::vec3(0, 0, 0));
 	auto projection = glm::perspective(glm::radians(40.0f), sdlm.size.ratio, 0.5f, 1000.0f);
 
 	Shader_Program lightingpass;
@@ -129,8 +185,6 @@ int main(int argc, char** argv) {
 	lightingpass.compile();
 	lightingpass.link();
 
-	auto uLightViewPos = lightingpass.getUniform("viewPos");
-
 	// Set gBuffer textures
 	lightingpass.use();
 	glUniform1i(lightingpass.getUniform("gPosition"), 0);
@@ -174,7 +228,6 @@ int main(int argc, char** argv) {
 	glUniform1i(ssaoPass1.getUniform("texNoise"), 3);
 
 	auto uSSAOPass1Samples = ssaoPass1.getUniform("samples", Shader::MANDITORY);
-	auto uSSAOPass1Projection = ssaoPass1.getUniform("projection", Shader::MANDITORY);
 
 	Shader_Program ssaoPass2;
 	ssaoPass2.add("shaders/lighting.v.glsl", Shader::VERTEX);
@@ -204,21 +257,47 @@ int main(int argc, char** argv) {
 	GLuint Monkey_VAO, Monkey_VBO;
 	std::tie(Monkey_VAO, Monkey_VBO) = render::upload_model(file);
 
-	// World
-	GLuint World_VAO, World_VBO;
-	std::tie(World_VAO, World_VBO) = render::upload_model(worldfile);
-
 	////////////////
 	// Init stuff //
 	////////////////
 
 	// lights::initialize();
 	// lights::add(glm::vec3{1.0, 1.0, 1.0}, glm::vec3{0, 0, 0});
-	gamegrid::initialize(11, 11);
+	auto world_storage = std::make_unique<game::World>();
+	auto&& world = *world_storage;
+	game::initialize(world, grid_width, grid_height, seed);
+	// Controllers that aren't plugged in are played by bots
+	Bot_Fields bot_fields;
+
+	// Every peer must be started with the same seed, size and tick rate
+	std::unique_ptr<Udp_Socket> socket;
+	std::unique_ptr<Rollback_Session> session;
+	if (peer_addresses.size() >= 2 && net.local_slot < peer_addresses.size()) {
+		socket = std::make_unique<Udp_Socket>(peer_addresses[net.local_slot].port);
+		if (!socket->is_open()) {
+			std::cerr << "Can't open UDP port " << peer_addresses[net.local_slot].port << '\n';
+			return 1;
+		}
+		net.player_count = peer_addresses.size();
+		session = std::make_unique<Rollback_Session>(world, 1.0f / tick_rate, net);
+	}
+	// With a server the match is played there and the world only mirrors its snapshots
+	std::unique_ptr<Snapshot_Client> client;
+	bool client_rate_set = false;
+	if (server_address.port != 0) {
+		client = std::make_unique<Snapshot_Client>(server_address, server_match);
+		if (!client->is_open()) {
+			std::cerr << "Can't open a UDP socket\n";
+			return 1;
+		}
+	}
+	Bit_Writer packet;
+	std::vector<uint8_t> datagram(2048);
+	gamegrid::initialize_render();
 	control::initialize();
-	players::initialize();
-	bullet::initialize();
-	bomb::initialize();
+	players::initialize_render();
+	bullet::initialize_render();
+	bomb::initialize_render();
 	ui::initialize();
 
 	/////////////////////
@@ -256,7 +335,7 @@ int main(int argc, char** argv) {
 	}
 
 	glGenTextures(1, &reninfo.ssaoNoiseTexture);
-	glBindTexture(GL_TEXTURE_2D, reninfo.ssaoNoiseTexture);
+	gl_state::bind_texture(0, reninfo.ssaoNoiseTexture);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, 4, 4, 0, GL_RGB, GL_FLOAT, &ssaoNoise[0]);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -266,12 +345,6 @@ int main(int argc, char** argv) {
 	ssaoPass1.use();
 	glUniform3fv(uSSAOPass1Samples, 64, glm::value_ptr(ssaoKernel[0]));
 
-	image::image nullimg;
-	nullimg.width = 1;
-	nullimg.height = 1;
-	nullimg.data.push_back(image::pixel{255, 255, 255, 255});
-	auto nullimg_tex = render::upload_texture(nullimg);
-
 	///////////////
 	// Game Loop //
 	///////////////
@@ -292,6 +365,7 @@ int main(int argc, char** argv) {
 	(void) mouseLY;
 
 	FPS_Meter fps(true, 2);
+	Fixed_Timestep timestep(tick_rate);
 	Camera cam(glm::vec3(0, 11, 12));
 	cam.set_rotation(45.5, 0);
 
@@ -446,12 +520,60 @@ int main(int argc, char** argv) {
 			cam.move(glm::vec3(0, -cameraSpeed, 0));
 		}
 
+		// Waits for the GPU to let go of the region this frame streams into
+		stream_buffer::begin_frame();
+
 		// lights::updatetransforms();
-		auto move_report = control::movement_report();
-		players::update_players(move_report, fps.get_delta_time());
-		bullet::update_bullets(fps.get_delta_time());
-		bomb::update_bombs(fps.get_delta_time());
-		gamegrid::read_controls(move_report);
+
+		// Run the simulation in fixed steps so the outcome doesn't depend on frame rate
+		if (client && client->is_connected() && !client_rate_set) {
+			timestep = Fixed_Timestep(1.0f / client->get_step());
+			client_rate_set = true;
+		}
+		timestep.advance(fps.get_delta_time());
+		while (timestep.tick()) {
+			if (client) {
+				if (client->receive()) {
+					net::apply(client->get_view(), client->get_step(), world);
+				}
+				client->send(control::movement_report()[0]);
+				continue;
+			}
+			if (!session) {
+				auto report = control::movement_report();
+				bot::drive(world, bot_fields, report, player_count);
+				game::update(world, report, timestep.get_step());
+				continue;
+			}
+
+			// The first controller plays the local slot, the other slots come from peers
+			Udp_Socket::address from;
+			while (auto size = socket->receive(from, datagram.data(), datagram.size())) {
+				session->read_packet(datagram.data(), size);
+			}
+			session->advance(control::movement_report()[0]);
+			for (std::size_t slot = 0; slot < peer_addresses.size(); ++slot) {
+				if (slot != net.local_slot) {
+					session->write_packet(slot, packet);
+					auto&& bytes = packet.finish();
+					socket->send(peer_addresses[slot], bytes.data(), bytes.size());
+				}
+			}
+		}
+		// How far we are between the last two ticks
+		float alpha = timestep.get_alpha();
+
+		// Camera and screen for every pass, uploaded once
+		render::frame_uniforms frame;
+		frame.view = cam.get_matrix();
+		frame.projection = projection;
+		frame.inverse_view = glm::inverse(frame.view);
+		frame.inverse_projection = glm::inverse(projection);
+		frame.camera_position = glm::vec4(cam.get_location(), 1.0f);
+		frame.resolution = glm::vec2(sdlm.size.width, sdlm.size.height);
+		frame.time = fps.get_time();
+		frame.padding = 0;
+		render::update_frame_uniforms(frame);
 
 		///////////////////
 		// Geometry Pass //
@@ -460,110 +582,92 @@ int main(int argc, char** argv) {
 		// Use geometry pass shaders
 		geometrypass.use();
 
-		// Update matrix uniforms
-		glUniformMatrix4fv(uGeoWorld, 1, GL_FALSE, glm::value_ptr(monkey_world));
-		glUniformMatrix4fv(uGeoView, 1, GL_FALSE, glm::value_ptr(cam.get_matrix()));
-		glUniformMatrix4fv(uGeoProjection, 1, GL_FALSE, glm::value_ptr(projection));
-
 		// Bind gBuffer in order to write to it
-		glBindFramebuffer(GL_FRAMEBUFFER, reninfo.gBuffer);
+		gl_state::bind_framebuffer(GL_FRAMEBUFFER, reninfo.gBuffer);
 
 		// Clear the gBuffer
 		glClearColor(0, 0, 0, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 		// Use normal depth function
-		glDepthFunc(GL_LESS);
-
-		// render::render_object(Monkey_VAO, Monkey_VBO, file.objects[0].vertices.size(),
-		// uGeoWorld);
+		gl_state::depth_func(GL_LESS);
 
-		// Bind world vertex data
-		render::render_object(World_VAO, World_VBO, worldfile.objects[0].vertices.size(),
-		                      nullimg_tex, uGeoWorld, world_world);
-
-		gamegrid::render(uGeoWorld);
-		players::render(uGeoWorld);
-		bullet::render(uGeoWorld);
-		bomb::render(uGeoWorld);
+		// Every module only queues its models, they are drawn together sorted by state
+		render::begin_queue(render::pass::geometry, geometrypass.getProgram(), cam.get_matrix());
+		gamegrid::render(world, projection * cam.get_matrix());
+		players::render(world, alpha);
+		bullet::render(world, alpha);
+		bomb::render(world);
+		render::draw_queue();
 
 		// Unbind arrays
-		glBindVertexArray(0);
+		gl_state::bind_vertex_array(0);
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 
 		// Unbind framebuffer
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		gl_state::bind_framebuffer(GL_FRAMEBUFFER, 0);
 
 		////////////////
 		// Depth Blit //
 		////////////////
 
 		// Blit depth pass to light buffer
-		glBindFramebuffer(GL_READ_FRAMEBUFFER, reninfo.gBuffer);
-		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, reninfo.lBuffer);
+		gl_state::bind_framebuffer(GL_READ_FRAMEBUFFER, reninfo.gBuffer);
+		gl_state::bind_framebuffer(GL_DRAW_FRAMEBUFFER, reninfo.lBuffer);
 
 		glBlitFramebuffer(0, 0, sdlm.size.width, sdlm.size.height, 0, 0, sdlm.size.width,
 		                  sdlm.size.height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
 
 		if (SSAO) {
 			// Blit depth pass to ssao buffer
-			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, reninfo.ssaoBuffer);
+			gl_state::bind_framebuffer(GL_DRAW_FRAMEBUFFER, reninfo.ssaoBuffer);
 
 			glBlitFramebuffer(0, 0, sdlm.size.width, sdlm.size.height, 0, 0, sdlm.size.width,
 			                  sdlm.size.height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
 		}
-		glBindFramebuffer(GL_FRAMEBUFFER, reninfo.lBuffer);
+		gl_state::bind_framebuffer(GL_FRAMEBUFFER, reninfo.lBuffer);
 
 		// Bind the buffers
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, reninfo.gPosition);
-		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, reninfo.gNormal);
-		glActiveTexture(GL_TEXTURE2);
-		glBindTexture(GL_TEXTURE_2D, reninfo.gAlbedoSpec);
-		glActiveTexture(GL_TEXTURE3);
-		glBindTexture(GL_TEXTURE_2D, reninfo.ssaoNoiseTexture);
-		glActiveTexture(GL_TEXTURE4);
-		glBindTexture(GL_TEXTURE_2D, reninfo.ssaoColor);
-		glActiveTexture(GL_TEXTURE5);
-		glBindTexture(GL_TEXTURE_2D, reninfo.ssaoBlurColor);
-		glActiveTexture(GL_TEXTURE6);
-		glBindTexture(GL_TEXTURE_2D, reninfo.gDepth);
+		gl_state::bind_texture(0, reninfo.gPosition);
+		gl_state::bind_texture(1, reninfo.gNormal);
+		gl_state::bind_texture(2, reninfo.gAlbedoSpec);
+		gl_state::bind_texture(3, reninfo.ssaoNoiseTexture);
+		gl_state::bind_texture(4, reninfo.ssaoColor);
+		gl_state::bind_texture(5, reninfo.ssaoBlurColor);
+		gl_state::bind_texture(6, reninfo.gDepth);
 
 		///////////////
 		// SSAO Pass //
 		///////////////
 
 		if (SSAO) {
-			glBindFramebuffer(GL_FRAMEBUFFER, reninfo.ssaoBuffer);
+			gl_state::bind_framebuffer(GL_FRAMEBUFFER, reninfo.ssaoBuffer);
 
 			glClearColor(1.0, 1.0, 1.0, 1.0);
 			glClear(GL_COLOR_BUFFER_BIT);
 
 			ssaoPass1.use();
 
-			glDepthFunc(GL_GREATER);
-			glDepthMask(GL_FALSE);
-
-			glUniformMatrix4fv(uSSAOPass1Projection, 1, GL_FALSE, glm::value_ptr(projection));
+			gl_state::depth_func(GL_GREATER);
+			gl_state::depth_mask(GL_FALSE);
 
 			render::render_fullscreen_quad();
 
 			ssaoPass2.use();
 
-			glBindFramebuffer(GL_FRAMEBUFFER, reninfo.ssaoBlurBuffer);
+			gl_state::bind_framebuffer(GL_FRAMEBUFFER, reninfo.ssaoBlurBuffer);
 			glClear(GL_COLOR_BUFFER_BIT);
 
 			render::render_fullscreen_quad();
 		}
 		else {
-			glBindFramebuffer(GL_FRAMEBUFFER, reninfo.ssaoBlurBuffer);
+			gl_state::bind_framebuffer(GL_FRAMEBUFFER, reninfo.ssaoBlurBuffer);
 
 			glClearColor(1.0, 1.0, 1.0, 1.0);
 			glClear(GL_COLOR_BUFFER_BIT);
 		}
 
-		glBindFramebuffer(GL_FRAMEBUFFER, reninfo.lBuffer);
+		gl_state::bind_framebuffer(GL_FRAMEBUFFER, reninfo.lBuffer);
 
 		///////////////////
 		// Lighting Pass //
@@ -577,16 +681,13 @@ int main(int argc, char** argv) {
 
 		// Fire the fragment shader if there is an object in front of the square
 		// The square is drawn at the very back
-		glDepthFunc(GL_GREATER);
-		glDepthMask(GL_FALSE);
-
-		// Upload current view position
-		glUniform3fv(uLightViewPos, 1, glm::value_ptr(cam.get_location()));
+		gl_state::depth_func(GL_GREATER);
+		gl_state::depth_mask(GL_FALSE);
 
 		// Render a quad
 		render::render_fullscreen_quad();
 
-		glDepthMask(GL_TRUE);
+		gl_state::depth_mask(GL_TRUE);
 
 		//////////////////////////////////
 		// Calculate Per Light Lighting //
@@ -670,22 +771,21 @@ int main(int argc, char** argv) {
 		// }
 
 		// Blit depth pass to current depth
-		glBindFramebuffer(GL_READ_FRAMEBUFFER, reninfo.gBuffer);
-		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, reninfo.lBuffer);
+		gl_state::bind_framebuffer(GL_READ_FRAMEBUFFER, reninfo.gBuffer);
+		gl_state::bind_framebuffer(GL_DRAW_FRAMEBUFFER, reninfo.lBuffer);
 
 		glBlitFramebuffer(0, 0, sdlm.size.width, sdlm.size.height, 0, 0, sdlm.size.width,
 		                  sdlm.size.height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
-		glBindFramebuffer(GL_FRAMEBUFFER, reninfo.lBuffer);
+		gl_state::bind_framebuffer(GL_FRAMEBUFFER, reninfo.lBuffer);
 
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		gl_state::bind_framebuffer(GL_FRAMEBUFFER, 0);
 
 		////////////////////////////
 		// HDR/Gamma Post Process //
 		////////////////////////////
 
 		// Average color
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, reninfo.lColor);
+		gl_state::bind_texture(0, reninfo.lColor);
 		glGenerateMipmap(GL_TEXTURE_2D);
 
 		int mipmap_levels =
@@ -708,7 +808,7 @@ int main(int argc, char** argv) {
 // std::cerr << luminosity << " - " << (1.0 / exposure) - (1.0 - 0.3) << '\n';
 #endif
 
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		gl_state::bind_framebuffer(GL_FRAMEBUFFER, 0);
 
 		hdr_pass.use();
 
@@ -717,13 +817,16 @@ int main(int argc, char** argv) {
 		glClearColor(0, 0, 0, 1);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		glDisable(GL_DEPTH_TEST);
+		gl_state::set_enabled(GL_DEPTH_TEST, false);
 
 		render::render_fullscreen_quad();
 
-		ui::render(sdlm.size.width, sdlm.size.height);
+		ui::render(world, sdlm.size.width, sdlm.size.height);
+
+		gl_state::set_enabled(GL_DEPTH_TEST, true);
 
-		glEnable(GL_DEPTH_TEST);
+		gl_state::end_frame();
+		stream_buffer::end_frame();
 
 		// Swap buffers
 		SDL_GL_SwapWindow(sdlm.mainWindow);
@@ -820,11 +923,11 @@ void Check_RenderBuffer() {
 
 void PrepareBuffers(int x, int y, RenderInfo& data) {
 	glGenFramebuffers(1, &data.gBuffer);
-	glBindFramebuffer(GL_FRAMEBUFFER, data.gBuffer);
+	gl_state::bind_framebuffer(GL_FRAMEBUFFER, data.gBuffer);
 
 	// - Position color buffer
 	glGenTextures(1, &data.gPosition);
-	glBindTexture(GL_TEXTURE_2D, data.gPosition);
+	gl_state::bind_texture(0, data.gPosition);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, x, y, 0, GL_RGB, GL_FLOAT, NULL);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -834,7 +937,7 @@ void PrepareBuffers(int x, int y, RenderInfo& data) {
 
 	// - Normal color buffer
 	glGenTextures(1, &data.gNormal);
-	glBindTexture(GL_TEXTURE_2D, data.gNormal);
+	gl_state::bind_texture(0, data.gNormal);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, x, y, 0, GL_RGB, GL_FLOAT, NULL);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -844,7 +947,7 @@ void PrepareBuffers(int x, int y, RenderInfo& data) {
 
 	// - Color + Specular color buffer
 	glGenTextures(1, &data.gAlbedoSpec);
-	glBindTexture(GL_TEXTURE_2D, data.gAlbedoSpec);
+	gl_state::bind_texture(0, data.gAlbedoSpec);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, x, y, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -855,7 +958,7 @@ void PrepareBuffers(int x, int y, RenderInfo& data) {
 
 	// - Depth buffer
 	glGenTextures(1, &data.gDepth);
-	glBindTexture(GL_TEXTURE_2D, data.gDepth);
+	gl_state::bind_texture(0, data.gDepth);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH32F_STENCIL8, x, y, 0, GL_DEPTH_STENCIL,
 	             GL_FLOAT_32_UNSIGNED_INT_24_8_REV, NULL);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
@@ -878,11 +981,11 @@ void PrepareBuffers(int x, int y, RenderInfo& data) {
 	///////////////////
 
 	glGenFramebuffers(1, &data.lBuffer);
-	glBindFramebuffer(GL_FRAMEBUFFER, data.lBuffer);
+	gl_state::bind_framebuffer(GL_FRAMEBUFFER, data.lBuffer);
 
 	// Light buffer
 	glGenTextures(1, &data.lColor);
-	glBindTexture(GL_TEXTURE_2D, data.lColor);
+	gl_state::bind_texture(0, data.lColor);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, x, y, 0, GL_RGB, GL_FLOAT, NULL);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -892,7 +995,7 @@ void PrepareBuffers(int x, int y, RenderInfo& data) {
 
 	// Depth Buffer
 	glGenTextures(1, &data.lDepth);
-	glBindTexture(GL_TEXTURE_2D, data.lDepth);
+	gl_state::bind_texture(0, data.lDepth);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH32F_STENCIL8, x, y, 0, GL_DEPTH_STENCIL,
 	             GL_FLOAT_32_UNSIGNED_INT_24_8_REV, NULL);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
@@ -909,10 +1012,10 @@ void PrepareBuffers(int x, int y, RenderInfo& data) {
 
 	// First pass
 	glGenFramebuffers(1, &data.ssaoBuffer);
-	glBindFramebuffer(GL_FRAMEBUFFER, data.ssaoBuffer);
+	gl_state::bind_framebuffer(GL_FRAMEBUFFER, data.ssaoBuffer);
 
 	glGenTextures(1, &data.ssaoColor);
-	glBindTexture(GL_TEXTURE_2D, data.ssaoColor);
+	gl_state::bind_texture(0, data.ssaoColor);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, x, y, 0, GL_RGB, GL_FLOAT, NULL);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -921,7 +1024,7 @@ void PrepareBuffers(int x, int y, RenderInfo& data) {
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, data.ssaoColor, 0);
 
 	glGenTextures(1, &data.ssaoDepth);
-	glBindTexture(GL_TEXTURE_2D, data.ssaoDepth);
+	gl_state::bind_texture(0, data.ssaoDepth);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, x, y, 0, GL_DEPTH_COMPONENT, GL_FLOAT,
 	             NULL);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
@@ -934,10 +1037,10 @@ void PrepareBuffers(int x, int y, RenderInfo& data) {
 
 	// Second pass
 	glGenFramebuffers(1, &data.ssaoBlurBuffer);
-	glBindFramebuffer(GL_FRAMEBUFFER, data.ssaoBlurBuffer);
+	gl_state::bind_framebuffer(GL_FRAMEBUFFER, data.ssaoBlurBuffer);
 
 	glGenTextures(1, &data.ssaoBlurColor);
-	glBindTexture(GL_TEXTURE_2D, data.ssaoBlurColor);
+	gl_state::bind_texture(0, data.ssaoBlurColor);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, x, y, 0, GL_RGB, GL_FLOAT, NULL);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -948,7 +1051,7 @@ void PrepareBuffers(int x, int y, RenderInfo& data) {
 
 	Check_RenderBuffer();
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	gl_state::bind_framebuffer(GL_FRAMEBUFFER, 0);
 }
 
 void DeleteBuffers(RenderInfo& data) {
@@ -964,6 +1067,8 @@ void DeleteBuffers(RenderInfo& data) {
 	glDeleteFramebuffers(1, &data.lBuffer);
 	glDeleteFramebuffers(1, &data.ssaoBuffer);
 	glDeleteFramebuffers(1, &data.ssaoBlurBuffer);
+	// Deleting unbinds, and new objects can be given the same names
+	gl_state::invalidate();
 }
 
 glm::mat4 Resize(SDL_Manager& sdlm, RenderInfo& data) {
@@ -1,17 +1,106 @@
 #include <GL/glew.h>
+#include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "gl_state.hpp"
 #include "render.hpp"
+#include "shader.hpp"
+#include "stream_buffer.hpp"
+#include "core/gamegrid.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+// Gribb/Hartmann: every plane is a sum or difference of the matrix's last row with
+// one of the others
+render::frustum render::extract_frustum(const glm::mat4& view_projection) {
+	auto row = [&](int r) {
+		return glm::vec4(view_projection[0][r], view_projection[1][r], view_projection[2][r],
+		                 view_projection[3][r]);
+	};
+
+	frustum f;
+	f.planes[0] = row(3) + row(0);
+	f.planes[1] = row(3) - row(0);
+	f.planes[2] = row(3) + row(1);
+	f.planes[3] = row(3) - row(1);
+	f.planes[4] = row(3) + row(2);
+	f.planes[5] = row(3) - row(2);
+	return f;
+}
+
+// A box is outside when its corner furthest along a plane's normal is still behind it
+bool render::intersects(const frustum& f, const glm::vec3& min, const glm::vec3& max) {
+	for (auto&& plane : f.planes) {
+		glm::vec3 corner(plane.x >= 0 ? max.x : min.x, plane.y >= 0 ? max.y : min.y,
+		                 plane.z >= 0 ? max.z : min.z);
+		if (glm::dot(glm::vec3(plane), corner) + plane.w < 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+glm::mat4 render::grid_transform(const gamegrid::GameGrid& grid, glm::vec2 location,
+                                 uint8_t quarter_turns) {
+	auto real_location = location - (glm::vec2{grid.width, grid.height} - 1.0f) / 2.0f;
+	auto translate = glm::translate(glm::mat4{}, glm::vec3(real_location.x, 0.5, real_location.y));
+	if (quarter_turns == 0) {
+		return translate;
+	}
+	return glm::rotate(translate, 1.570796327f * quarter_turns, glm::vec3(0, 1, 0));
+}
+
+struct queue_item {
+	GLuint program;
+	GLuint vao;
+	GLuint tex;
+	uint32_t vertices;
+	glm::mat4 world;
+};
+struct sort_entry {
+	uint64_t key;
+	uint32_t index;
+};
+// Vectors live as long as the program so they keep their capacity, a frame only
+// empties them
+static std::vector<queue_item> queue_items;
+static std::vector<sort_entry> queue_order, queue_scratch;
+static std::vector<glm::mat4> instance_staging;
+static render::pass queue_pass = render::pass::geometry;
+static GLuint queue_program = 0;
+static glm::mat4 queue_view;
+static render::queue_stats queue_counters;
+
+// Points the world matrix attributes of the bound vertex array at the matrix with the
+// given index, in matrices that start at base in the bound array buffer
+static void point_instances(std::size_t base, std::size_t first) {
+	for (GLuint c = 0; c < 4; ++c) {
+		auto offset = base + first * sizeof(glm::mat4) + c * sizeof(glm::vec4);
+		glVertexAttribPointer(3 + c, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+		                      reinterpret_cast<GLvoid*>(offset));
+	}
+}
+
+void render::update_frame_uniforms(const frame_uniforms& frame) {
+	auto where = stream_buffer::push(&frame, sizeof(frame_uniforms));
+	glBindBufferRange(GL_UNIFORM_BUFFER, Shader::frame_binding, where.buffer,
+	                  static_cast<GLintptr>(where.offset), sizeof(frame_uniforms));
+}
 
 std::tuple<GLuint, GLuint> render::upload_model(const ObjFile& file) {
+	return upload_vertices(file.objects[0].vertices);
+}
+
+std::tuple<GLuint, GLuint> render::upload_vertices(const std::vector<Vertex>& vertices) {
 	GLuint VAO, VBO;
 	glGenVertexArrays(1, &VAO);
-	glBindVertexArray(VAO);
+	gl_state::bind_vertex_array(VAO);
 
 	glGenBuffers(1, &VBO);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, file.objects[0].vertices.size() * sizeof(Vertex),
-	             file.objects[0].vertices.data(), GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(),
+	             GL_STATIC_DRAW);
 
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat),
 	                      reinterpret_cast<GLvoid*>(0 * sizeof(GLfloat))); // Position
@@ -24,7 +113,13 @@ std::tuple<GLuint, GLuint> render::upload_model(const ObjFile& file) {
 	glEnableVertexAttribArray(1);
 	glEnableVertexAttribArray(2);
 
-	glBindVertexArray(0);
+	// Pointed at the frame's matrices by draw_queue()
+	for (GLuint c = 0; c < 4; ++c) {
+		glEnableVertexAttribArray(3 + c);
+		glVertexAttribDivisor(3 + c, 1);
+	}
+
+	gl_state::bind_vertex_array(0);
 
 	return std::make_tuple(VAO, VBO);
 }
@@ -33,7 +128,7 @@ GLuint render::upload_texture(const image::image& img, bool srgb) {
 	GLuint id;
 
 	glGenTextures(1, &id);
-	glBindTexture(GL_TEXTURE_2D, id);
+	gl_state::bind_texture(0, id);
 	glTexImage2D(GL_TEXTURE_2D, 0, srgb ? GL_SRGB8_ALPHA8 : GL_RGBA, img.width, img.height, 0,
 	             GL_RGBA, GL_UNSIGNED_BYTE, img.data.data());
 	glGenerateMipmap(GL_TEXTURE_2D);
@@ -41,23 +136,122 @@ GLuint render::upload_texture(const image::image& img, bool srgb) {
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	gl_state::bind_texture(0, 0);
 
 	return id;
 }
 
-void render::render_object(GLuint VAO, GLuint VBO, std::size_t vertices, GLuint tex,
-                           GLuint world_matrix_uniform, glm::mat4 world_matrix) {
-	// Bind world vertex data
-	glBindVertexArray(VAO);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+// Key bits, high to low: pass 4, program 12, vertex array 14, texture 14, depth 20.
+// Names are cut to their low bits, which only matters for the order of runs, runs
+// themselves are split by the full names.
+static uint64_t sort_key(render::pass p, GLuint program, GLuint VAO, GLuint tex, float depth) {
+	// Bits of a positive float sort like the float does, the top 20 after the sign keep
+	// the exponent and 11 bits of mantissa
+	uint32_t depth_bits = 0;
+	if (depth > 0) {
+		std::memcpy(&depth_bits, &depth, sizeof(depth));
+	}
+	return uint64_t(static_cast<uint8_t>(p) & 0xF) << 60 | uint64_t(program & 0xFFF) << 48 |
+	       uint64_t(VAO & 0x3FFF) << 34 | uint64_t(tex & 0x3FFF) << 20 | depth_bits >> 11;
+}
+
+// Least significant digit first, a byte per pass. Passes where every key has the same
+// byte are skipped, which is most of them for a frame's worth of keys.
+static void radix_sort(std::vector<sort_entry>& entries, std::vector<sort_entry>& scratch) {
+	scratch.resize(entries.size());
+	for (unsigned shift = 0; shift < 64; shift += 8) {
+		std::array<std::size_t, 257> offsets = {};
+		for (auto&& e : entries) {
+			offsets[((e.key >> shift) & 0xFF) + 1] += 1;
+		}
+		if (std::find(offsets.begin(), offsets.end(), entries.size()) != offsets.end()) {
+			continue;
+		}
+		for (std::size_t d = 1; d < offsets.size(); ++d) {
+			offsets[d] += offsets[d - 1];
+		}
+		for (auto&& e : entries) {
+			scratch[offsets[(e.key >> shift) & 0xFF]++] = e;
+		}
+		std::swap(entries, scratch);
+	}
+}
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, tex);
+void render::begin_queue(pass p, GLuint program, const glm::mat4& view) {
+	queue_pass = p;
+	queue_program = program;
+	queue_view = view;
+}
 
-	glUniformMatrix4fv(world_matrix_uniform, 1, GL_FALSE, glm::value_ptr(world_matrix));
+void render::submit(GLuint VAO, std::size_t vertices, GLuint tex, const glm::mat4& world_matrix) {
+	// Distance in front of the camera of the model's origin
+	auto depth = -(queue_view * world_matrix[3]).z;
+	auto key = sort_key(queue_pass, queue_program, VAO, tex, depth);
+	queue_order.push_back(sort_entry{key, static_cast<uint32_t>(queue_items.size())});
+	queue_items.push_back(
+	    queue_item{queue_program, VAO, tex, static_cast<uint32_t>(vertices), world_matrix});
+}
+
+void render::draw_queue() {
+	queue_counters = queue_stats{};
+	queue_counters.items = queue_items.size();
+	if (queue_items.empty()) {
+		return;
+	}
+
+	radix_sort(queue_order, queue_scratch);
+	instance_staging.clear();
+	for (auto&& e : queue_order) {
+		instance_staging.push_back(queue_items[e.index].world);
+	}
+
+	auto instances = stream_buffer::push(instance_staging.data(),
+	                                     instance_staging.size() * sizeof(glm::mat4));
+	glBindBuffer(GL_ARRAY_BUFFER, instances.buffer);
+
+	const queue_item* bound = nullptr;
+	auto rebind = [&](bool changed) {
+		queue_counters.binds += changed ? 1 : 0;
+		queue_counters.binds_avoided += changed ? 0 : 1;
+		return changed;
+	};
+	std::size_t first = 0;
+	while (first < queue_order.size()) {
+		auto&& item = queue_items[queue_order[first].index];
+		auto last = first + 1;
+		while (last < queue_order.size()) {
+			auto&& next = queue_items[queue_order[last].index];
+			if (next.program != item.program || next.vao != item.vao || next.tex != item.tex) {
+				break;
+			}
+			last += 1;
+		}
+
+		if (rebind(!bound || bound->program != item.program)) {
+			gl_state::use_program(item.program);
+		}
+		if (rebind(!bound || bound->vao != item.vao)) {
+			gl_state::bind_vertex_array(item.vao);
+		}
+		if (rebind(!bound || bound->tex != item.tex)) {
+			gl_state::bind_texture(0, item.tex);
+		}
+		bound = &item;
+
+		point_instances(instances.offset, first);
+		glDrawArraysInstanced(GL_TRIANGLES, 0, static_cast<GLsizei>(item.vertices),
+		                      static_cast<GLsizei>(last - first));
+		queue_counters.draw_calls += 1;
+		first = last;
+	}
+	gl_state::bind_vertex_array(0);
+
+	queue_items.clear();
+	queue_order.clear();
+}
 
-	glDrawArrays(GL_TRIANGLES, 0, static_cast<int>(vertices));
+const render::queue_stats& render::get_queue_stats() {
+	return queue_counters;
 }
 
 // RenderQuad() Renders a 1x1 quad in NDC, best used for framebuffer color
@@ -75,7 +269,7 @@ void render::render_fullscreen_quad() {
 		// Setup plane VAO
 		glGenVertexArrays(1, &quadVAO);
 		glGenBuffers(1, &quadVBO);
-		glBindVertexArray(quadVAO);
+		gl_state::bind_vertex_array(quadVAO);
 		glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
 		glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
 		glEnableVertexAttribArray(0);
@@ -85,7 +279,6 @@ void render::render_fullscreen_quad() {
 		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat),
 		                      reinterpret_cast<GLvoid*>(3 * sizeof(GLfloat)));
 	}
-	glBindVertexArray(quadVAO);
+	gl_state::bind_vertex_array(quadVAO);
 	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-	glBindVertexArray(0);
 }
@@ -3,13 +3,76 @@
 #include "image.hpp"
 #include "objparser.hpp"
 #include <GL/glew.h>
+#include <array>
 #include <glm/glm.hpp>
 #include <tuple>
+#include <vector>
+
+namespace gamegrid {
+	struct GameGrid;
+}
 
 namespace render {
+	// Planes (a, b, c, d) facing inwards, a point p is inside when dot(abc, p) + d >= 0
+	struct frustum {
+		std::array<glm::vec4, 6> planes;
+	};
+
+	frustum extract_frustum(const glm::mat4& view_projection);
+	bool intersects(const frustum& f, const glm::vec3& min, const glm::vec3& max);
+
+	// Model matrix for something standing at a location on the grid, turned by a number
+	// of quarter turns. The grid is centered on the origin, its rows run along z.
+	glm::mat4 grid_transform(const gamegrid::GameGrid& grid, glm::vec2 location,
+	                         uint8_t quarter_turns = 0);
+
+	// Per frame values shared by every program, the Frame uniform block in the shaders.
+	// Laid out as std140, members only go at offsets the block puts them at.
+	struct frame_uniforms {
+		glm::mat4 view;
+		glm::mat4 projection;
+		glm::mat4 inverse_view;
+		glm::mat4 inverse_projection;
+		// xyz, w unused
+		glm::vec4 camera_position;
+		glm::vec2 resolution;
+		// Seconds since the start
+		float time;
+		float padding;
+	};
+	static_assert(sizeof(frame_uniforms) == 288, "frame_uniforms must match the std140 block");
+
+	// Uploads the frame's values once for every program, call before the first pass
+	void update_frame_uniforms(const frame_uniforms& frame);
+
+	// Vertex arrays made here also read a world matrix per instance from attributes 3 to 6
 	std::tuple<GLuint, GLuint> upload_model(const ObjFile& file);
+	std::tuple<GLuint, GLuint> upload_vertices(const std::vector<Vertex>& vertices);
 	GLuint upload_texture(const image::image& img, bool srgb = true);
-	void render_object(GLuint VAO, GLuint VBO, std::size_t vertices, GLuint tex_id,
-	                   GLuint world_matrix_uniform, glm::mat4 world_matrix = glm::mat4{});
+
+	// Draw queue for a pass. Modules submit copies of models in whatever order they
+	// like, each tagged with a sort key of the pass, program, vertex array, texture and
+	// depth. draw_queue() radix sorts them by key, uploads every world matrix at once and
+	// draws each run of copies sharing a program, vertex array and texture with a single
+	// instanced call, binding only what changed since the previous run. Within a run
+	// copies go front to back.
+	enum class pass : uint8_t { geometry = 0 };
+
+	// Starts queueing for a pass drawn with program, depths are taken along view
+	void begin_queue(pass p, GLuint program, const glm::mat4& view);
+	void submit(GLuint VAO, std::size_t vertices, GLuint tex_id, const glm::mat4& world_matrix);
+	void draw_queue();
+
+	struct queue_stats {
+		std::size_t items = 0;
+		std::size_t draw_calls = 0;
+		// Program, vertex array and texture binds made, and those skipped because the
+		// previous run already had the same one bound
+		std::size_t binds = 0;
+		std::size_t binds_avoided = 0;
+	};
+	// What the last draw_queue() drew
+	const queue_stats& get_queue_stats();
+
 	void render_fullscreen_quad();
 }
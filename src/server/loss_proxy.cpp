@@ -0,0 +1,54 @@
+#include "loss_proxy.hpp"
+
+#include <algorithm>
+
+Loss_Proxy::Loss_Proxy(const settings& config_, uint16_t port, const Udp_Socket::address& upstream)
+    : config(config_), socket(port), server(upstream), prng(config_.seed), datagram(65536) {}
+
+Loss_Proxy::~Loss_Proxy() = default;
+
+void Loss_Proxy::enqueue(double now, bool to_server, std::size_t link, std::size_t size) {
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	if (unit(prng) < config.loss) {
+		counters.dropped += 1;
+		return;
+	}
+
+	auto deliver_at = now + config.latency + config.jitter * unit(prng);
+	auto position = std::upper_bound(queue.begin(), queue.end(), deliver_at,
+	                                 [](double t, auto&& d) { return t < d.deliver_at; });
+	queue.insert(position, delayed{deliver_at, to_server, link,
+	                               std::vector<uint8_t>(datagram.begin(),
+	                                                    datagram.begin() + size)});
+}
+
+void Loss_Proxy::pump(double now) {
+	Udp_Socket::address from;
+	while (auto size = socket.receive(from, datagram.data(), datagram.size())) {
+		auto key = (uint64_t(from.host) << 16) | from.port;
+		auto found = link_index.find(key);
+		if (found == link_index.end()) {
+			found = link_index.emplace(key, links.size()).first;
+			links.push_back(client_link{from, std::make_unique<Udp_Socket>()});
+		}
+		enqueue(now, true, found->second, size);
+	}
+	for (std::size_t l = 0; l < links.size(); ++l) {
+		while (auto size = links[l].upstream->receive(from, datagram.data(), datagram.size())) {
+			enqueue(now, false, l, size);
+		}
+	}
+
+	while (!queue.empty() && queue.front().deliver_at <= now) {
+		auto&& d = queue.front();
+		auto&& link = links[d.link];
+		if (d.to_server) {
+			link.upstream->send(server, d.bytes.data(), d.bytes.size());
+		}
+		else {
+			socket.send(link.client, d.bytes.data(), d.bytes.size());
+		}
+		counters.forwarded += 1;
+		queue.pop_front();
+	}
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "core/udp_socket.hpp"
+
+#include <cinttypes>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+// Sits between clients and a server and makes the link worse on purpose: every
+// datagram either way is delayed by latency plus up to jitter seconds, and dropped
+// with probability loss. Each client gets its own socket towards the server, so the
+// server sees one address per client as it would without the proxy.
+class Loss_Proxy {
+  public:
+	struct settings {
+		// Seconds one way
+		float latency = 0.05f;
+		float jitter = 0.0f;
+		// Fraction of datagrams dropped
+		float loss = 0.0f;
+		uint32_t seed = 0;
+	};
+
+	struct stats {
+		uint64_t forwarded = 0;
+		uint64_t dropped = 0;
+	};
+
+	Loss_Proxy(const settings& config, uint16_t port, const Udp_Socket::address& upstream);
+	~Loss_Proxy();
+
+	bool is_open() const {
+		return socket.is_open();
+	}
+	uint16_t get_port() const {
+		return socket.get_port();
+	}
+
+	// Reads whatever arrived on either side and sends whatever is due by now, in seconds
+	void pump(double now);
+
+	const stats& get_stats() const {
+		return counters;
+	}
+
+  private:
+	struct client_link {
+		Udp_Socket::address client;
+		std::unique_ptr<Udp_Socket> upstream;
+	};
+
+	struct delayed {
+		double deliver_at;
+		// Towards the server through the client's link, otherwise towards the client
+		bool to_server;
+		std::size_t link;
+		std::vector<uint8_t> bytes;
+	};
+
+	void enqueue(double now, bool to_server, std::size_t link, std::size_t size);
+
+	settings config;
+	Udp_Socket socket;
+	Udp_Socket::address server;
+	std::vector<client_link> links;
+	std::unordered_map<uint64_t, std::size_t> link_index;
+	// Kept sorted by delivery time
+	std::deque<delayed> queue;
+	std::mt19937 prng;
+	std::vector<uint8_t> datagram;
+	stats counters;
+};
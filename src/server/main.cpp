@@ -0,0 +1,246 @@
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "loss_proxy.hpp"
+#include "match_server.hpp"
+#include "core/net_client.hpp"
+
+static void print_usage() {
+	std::cerr << "Usage: bomberman_server [--port N] [--matches N] [--size WxH] [--tick-rate hz]\n"
+	             "                        [--threads N] [--seed N] [--timeout seconds]\n"
+	             "                        [--players N] [--bots 0|1]\n"
+	             "       bomberman_server --proxy port --upstream a.b.c.d:port [--latency ms]\n"
+	             "                        [--jitter ms] [--loss %]\n"
+	             "       bomberman_server --test clients [--length seconds] [--latency ms]\n"
+	             "                        [--jitter ms] [--loss %] [--matches N] [--size WxH]\n"
+	             "                        [--tick-rate hz]\n";
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count();
+}
+
+static void print_server_stats(const Match_Server& server, std::size_t matches) {
+	auto&& s = server.get_stats();
+	std::cout << "Server: " << s.ticks << " ticks, " << s.clients << " clients joined, "
+	          << s.full_snapshots << " full and " << s.delta_snapshots << " delta snapshots, "
+	          << s.bytes_sent << " bytes sent, " << s.oversized << " too big to send\n";
+	std::cout << "Tick: " << s.tick_seconds / static_cast<double>(s.ticks) * 1000.0
+	          << "ms average, " << s.max_tick_seconds * 1000.0 << "ms worst for " << matches
+	          << " matches\n";
+}
+
+// Runs until killed, one tick every step of real time
+static int serve(const Match_Server::settings& config, uint16_t port) {
+	Match_Server server(config, port);
+	if (!server.is_open()) {
+		std::cerr << "Can't open UDP port " << port << '\n';
+		return 1;
+	}
+	std::cout << "Serving " << config.matches << " matches on port " << server.get_port()
+	          << '\n';
+
+	auto start = std::chrono::steady_clock::now();
+	auto step = std::chrono::duration<double>(server.get_step());
+	auto next_tick = start;
+	auto next_report = start + std::chrono::seconds(10);
+	while (true) {
+		server.tick(seconds_since(start));
+		next_tick += std::chrono::duration_cast<std::chrono::steady_clock::duration>(step);
+		if (next_tick > next_report) {
+			print_server_stats(server, config.matches);
+			next_report += std::chrono::seconds(10);
+		}
+		std::this_thread::sleep_until(next_tick);
+	}
+}
+
+static int proxy(const Loss_Proxy::settings& config, uint16_t port,
+                 const Udp_Socket::address& upstream) {
+	Loss_Proxy link(config, port, upstream);
+	if (!link.is_open()) {
+		std::cerr << "Can't open UDP port " << port << '\n';
+		return 1;
+	}
+	auto start = std::chrono::steady_clock::now();
+	while (true) {
+		link.pump(seconds_since(start));
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+// Server, proxy and clients in one process, stepped together on a virtual clock so a
+// run takes as long as the simulation does rather than its length
+static int loopback_test(const Match_Server::settings& config,
+                         const Loss_Proxy::settings& link_config, std::size_t client_count,
+                         float length) {
+	Match_Server server(config, 0);
+	Loss_Proxy link(link_config, 0, Udp_Socket::loopback(server.get_port()));
+	if (!server.is_open() || !link.is_open()) {
+		std::cerr << "Can't open UDP sockets\n";
+		return 1;
+	}
+
+	std::vector<std::unique_ptr<Snapshot_Client>> clients;
+	for (std::size_t c = 0; c < client_count; ++c) {
+		clients.push_back(
+		    std::make_unique<Snapshot_Client>(Udp_Socket::loopback(link.get_port())));
+	}
+
+	// Held stick directions and the odd shot, like someone playing
+	std::mt19937 prng(config.seed);
+	std::bernoulli_distribution change(1.0 / 12.0);
+	std::bernoulli_distribution trigger(0.1);
+	std::uniform_int_distribution<int> direction(0, 4);
+	std::vector<control::controller_report> inputs(client_count);
+	for (auto&& input : inputs) {
+		input = control::controller_report();
+	}
+
+	const auto step = static_cast<double>(server.get_step());
+	const auto ticks = static_cast<uint64_t>(length * config.tick_rate);
+	auto start = std::chrono::steady_clock::now();
+	for (uint64_t t = 0; t < ticks; ++t) {
+		auto now = static_cast<double>(t) * step;
+		for (std::size_t c = 0; c < client_count; ++c) {
+			clients[c]->receive();
+			if (change(prng)) {
+				inputs[c].left_stick_dir =
+				    static_cast<control::controller_report::direction>(direction(prng));
+				inputs[c].ltrigger = trigger(prng);
+				inputs[c].rtrigger = trigger(prng);
+			}
+			clients[c]->send(inputs[c]);
+		}
+		link.pump(now);
+		server.tick(now);
+		link.pump(now);
+	}
+	auto elapsed = seconds_since(start);
+
+	Snapshot_Client::stats total;
+	std::size_t connected = 0;
+	for (auto&& client : clients) {
+		auto&& s = client->get_stats();
+		connected += client->is_connected() ? 1 : 0;
+		total.bytes_sent += s.bytes_sent;
+		total.bytes_received += s.bytes_received;
+		total.snapshots += s.snapshots;
+		total.full += s.full;
+		total.deltas += s.deltas;
+		total.rejected += s.rejected;
+		total.mismatches += s.mismatches;
+	}
+
+	auto per_client = [&](uint64_t value) {
+		return static_cast<double>(value) / static_cast<double>(client_count) / length / 1024.0;
+	};
+	std::cout << "Loopback: " << ticks << " ticks at " << config.tick_rate << "Hz, "
+	          << connected << '/' << client_count << " clients connected, " << elapsed
+	          << "s wall\n";
+	std::cout << "Per client: " << per_client(total.bytes_received) << " KB/s down, "
+	          << per_client(total.bytes_sent) << " KB/s up\n";
+	std::cout << "Snapshots: " << total.snapshots << " decoded (" << total.full << " full, "
+	          << total.deltas << " delta), " << total.rejected << " rejected, "
+	          << total.mismatches << " checksum mismatches\n";
+	std::cout << "Proxy: " << link.get_stats().forwarded << " forwarded, "
+	          << link.get_stats().dropped << " dropped\n";
+	print_server_stats(server, config.matches);
+
+	bool clean = total.rejected == 0 && total.mismatches == 0;
+	return connected == client_count && total.snapshots > 0 && clean ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+	Match_Server::settings config;
+	config.seed = std::random_device{}();
+	Loss_Proxy::settings link;
+	uint16_t port = 27015;
+	uint16_t proxy_port = 0;
+	Udp_Socket::address upstream;
+	std::size_t test_clients = 0;
+	float length = 60.0f;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (i + 1 >= argc) {
+			print_usage();
+			return 1;
+		}
+		std::string value = argv[++i];
+
+		if (arg == "--port") {
+			port = static_cast<uint16_t>(std::stoul(value));
+		}
+		else if (arg == "--matches") {
+			config.matches = std::stoul(value);
+		}
+		else if (arg == "--size") {
+			config.width = std::stoul(value);
+			auto split = value.find('x');
+			config.height = split == std::string::npos ? config.width
+			                                           : std::stoul(value.substr(split + 1));
+		}
+		else if (arg == "--tick-rate") {
+			config.tick_rate = std::stof(value);
+		}
+		else if (arg == "--threads") {
+			config.threads = std::stoul(value);
+		}
+		else if (arg == "--seed") {
+			config.seed = static_cast<uint32_t>(std::stoul(value));
+		}
+		else if (arg == "--timeout") {
+			config.timeout = std::stod(value);
+		}
+		else if (arg == "--players") {
+			config.players = std::stoul(value);
+		}
+		else if (arg == "--bots") {
+			config.bots = value != "0";
+		}
+		else if (arg == "--proxy") {
+			proxy_port = static_cast<uint16_t>(std::stoul(value));
+		}
+		else if (arg == "--upstream") {
+			if (!Udp_Socket::parse_address(value, upstream)) {
+				std::cerr << "Bad address " << value << '\n';
+				return 1;
+			}
+		}
+		else if (arg == "--latency") {
+			link.latency = std::stof(value) / 1000.0f;
+		}
+		else if (arg == "--jitter") {
+			link.jitter = std::stof(value) / 1000.0f;
+		}
+		else if (arg == "--loss") {
+			link.loss = std::stof(value) / 100.0f;
+		}
+		else if (arg == "--test") {
+			test_clients = std::stoul(value);
+		}
+		else if (arg == "--length") {
+			length = std::stof(value);
+		}
+		else {
+			print_usage();
+			return 1;
+		}
+	}
+
+	link.seed = config.seed;
+	if (test_clients > 0) {
+		return loopback_test(config, link, test_clients, length);
+	}
+	if (proxy_port != 0) {
+		return proxy(link, proxy_port, upstream);
+	}
+	return serve(config, port);
+}
@@ -0,0 +1,205 @@
+#include "match_server.hpp"
+
+#include "core/game.hpp"
+#include "core/replay.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+static uint64_t address_key(const Udp_Socket::address& addr) {
+	return (uint64_t(addr.host) << 16) | addr.port;
+}
+
+// Slot that nobody plays, and a player that joined but hasn't sent anything yet
+static uint32_t empty_report() {
+	return replay::pack_report(replay::unpack_report(0));
+}
+
+static uint32_t idle_report() {
+	control::controller_report report = replay::unpack_report(0);
+	report.active = true;
+	return replay::pack_report(report);
+}
+
+Match_Server::Match_Server(const settings& config_, uint16_t port)
+    : config(config_), step(1.0f / config_.tick_rate), socket(port), pool(config_.threads),
+      matches(config_.matches), datagram(net::max_datagram) {
+	config.players = std::min(std::max<std::size_t>(config.players, 1), control::max_players);
+	for (std::size_t m = 0; m < matches.size(); ++m) {
+		auto&& match = matches[m];
+		match.world = std::make_unique<game::World>();
+		game::initialize(*match.world, config.width, config.height,
+		                 config.seed + static_cast<uint32_t>(m));
+		for (auto&& slot : match.slots) {
+			slot.packed = empty_report();
+		}
+	}
+}
+
+Match_Server::~Match_Server() = default;
+
+void Match_Server::tick(double now) {
+	Udp_Socket::address from;
+	while (auto size = socket.receive(from, datagram.data(), datagram.size())) {
+		read_datagram(from, datagram.data(), size, now);
+	}
+	drop_idle(now);
+
+	auto start = std::chrono::steady_clock::now();
+	for (auto&& match : matches) {
+		pool.submit([this, &match] { play(match); });
+	}
+	pool.wait();
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	counters.tick_seconds += elapsed.count();
+	counters.max_tick_seconds = std::max(counters.max_tick_seconds, elapsed.count());
+	counters.ticks += 1;
+
+	for (auto&& match : matches) {
+		for (auto&& out : match.outbox) {
+			if (out.bytes.size() > net::max_datagram) {
+				counters.oversized += 1;
+				continue;
+			}
+			socket.send(out.to, out.bytes.data(), out.bytes.size());
+			counters.bytes_sent += out.bytes.size();
+			counters.full_snapshots += out.full ? 1 : 0;
+			counters.delta_snapshots += out.full ? 0 : 1;
+		}
+	}
+}
+
+void Match_Server::read_datagram(const Udp_Socket::address& from, const uint8_t* data,
+                                 std::size_t size, double now) {
+	counters.datagrams_received += 1;
+
+	Bit_Reader in(data, size);
+	auto kind = static_cast<net::message>(in.read(net::message_bits));
+	auto known = seats.find(address_key(from));
+
+	if (kind == net::message::hello) {
+		auto wanted = in.read(16);
+		if (in.overflowed()) {
+			counters.datagrams_rejected += 1;
+			return;
+		}
+		// The welcome may have been lost, a known client is just told again
+		if (known != seats.end()) {
+			welcome(from, known->second);
+			return;
+		}
+
+		auto first = wanted == net::any_match ? 0 : static_cast<std::size_t>(wanted);
+		auto last = wanted == net::any_match ? matches.size() : first + 1;
+		for (auto m = first; m < std::min(last, matches.size()); ++m) {
+			auto&& slots = matches[m].slots;
+			auto played = slots.begin() + static_cast<std::ptrdiff_t>(config.players);
+			auto free_slot =
+			    std::find_if(slots.begin(), played, [](auto&& s) { return !s.occupied; });
+			if (free_slot == played) {
+				continue;
+			}
+
+			free_slot->occupied = true;
+			free_slot->client = from;
+			free_slot->acked = -1;
+			free_slot->packed = idle_report();
+			free_slot->heard = now;
+			seat place{m, static_cast<std::size_t>(free_slot - slots.begin())};
+			seats.emplace(address_key(from), place);
+			counters.clients += 1;
+			welcome(from, place);
+			return;
+		}
+		// Every slot is taken, the client keeps asking
+		return;
+	}
+
+	if (kind == net::message::input && known != seats.end()) {
+		auto ack = in.read(32);
+		auto packed = in.read(replay::packed_bits);
+		if (in.overflowed()) {
+			counters.datagrams_rejected += 1;
+			return;
+		}
+		auto&& slot = matches[known->second.match].slots[known->second.slot];
+		// All ones is a client without any view yet
+		if (ack != 0xFFFFFFFF) {
+			slot.acked = std::max<int64_t>(slot.acked, ack);
+		}
+		slot.packed = packed;
+		slot.heard = now;
+		return;
+	}
+
+	counters.datagrams_rejected += 1;
+}
+
+void Match_Server::welcome(const Udp_Socket::address& to, const seat& place) {
+	uint32_t step_bits;
+	std::memcpy(&step_bits, &step, sizeof(step_bits));
+
+	packet.clear();
+	packet.write(static_cast<uint32_t>(net::message::welcome), net::message_bits);
+	packet.write(static_cast<uint32_t>(place.match), 16);
+	packet.write(static_cast<uint32_t>(place.slot), 8);
+	packet.write(step_bits, 32);
+	auto&& bytes = packet.finish();
+	socket.send(to, bytes.data(), bytes.size());
+	counters.bytes_sent += bytes.size();
+}
+
+void Match_Server::drop_idle(double now) {
+	for (auto&& match : matches) {
+		for (auto&& slot : match.slots) {
+			if (slot.occupied && now - slot.heard > config.timeout) {
+				seats.erase(address_key(slot.client));
+				slot = slot_state();
+				slot.packed = empty_report();
+			}
+		}
+	}
+}
+
+// Runs on a pool thread and only touches its own match
+void Match_Server::play(match_state& match) {
+	static const net::view empty;
+
+	auto&& world = *match.world;
+	control::movement_report_type report;
+	for (std::size_t s = 0; s < report.size(); ++s) {
+		report[s] = replay::unpack_report(match.slots[s].packed);
+	}
+	if (config.bots) {
+		bot::drive(world, match.bot_fields, report, config.players);
+	}
+	game::update(world, report, step);
+
+	auto tick = world.tick;
+	auto&& now = match.views[tick % net::history];
+	net::capture(world, match.views[(tick - 1) % net::history], now);
+	auto sum = net::checksum(now);
+
+	match.outbox.clear();
+	for (auto&& slot : match.slots) {
+		if (!slot.occupied) {
+			continue;
+		}
+
+		// A base the client may no longer hold, or one too far back, isn't used
+		auto back = slot.acked < 0 ? 0 : static_cast<int64_t>(tick) - slot.acked;
+		if (back <= 0 || back >= static_cast<int64_t>(net::history)) {
+			back = 0;
+		}
+		auto&& base = back == 0 ? empty : match.views[(tick - back) % net::history];
+
+		auto&& out = match.writer;
+		out.clear();
+		out.write(static_cast<uint32_t>(net::message::snapshot), net::message_bits);
+		out.write(static_cast<uint32_t>(back), 6);
+		out.write(sum, 32);
+		net::write_delta(out, base, now);
+		match.outbox.push_back(outgoing{slot.client, out.finish(), back == 0});
+	}
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "core/bitstream.hpp"
+#include "core/bot.hpp"
+#include "core/controller_report.hpp"
+#include "core/net_view.hpp"
+#include "core/thread_pool.hpp"
+#include "core/udp_socket.hpp"
+
+#include <array>
+#include <cinttypes>
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace game {
+	struct World;
+}
+
+// Dedicated server for many matches at once. Clients only send inputs, every match
+// is simulated here and each client is sent its match's view every tick as a delta
+// against the newest view it acknowledged. Matches run in parallel on a thread pool,
+// each one encodes its own snapshots so the main thread only moves datagrams.
+class Match_Server {
+  public:
+	struct settings {
+		std::size_t matches = 8;
+		std::size_t width = 11;
+		std::size_t height = 11;
+		float tick_rate = 60.0f;
+		uint32_t seed = 0;
+		// Slots clients and bots can take in each match, from the first one
+		std::size_t players = 4;
+		std::size_t threads = std::thread::hardware_concurrency();
+		// Seconds without a datagram before a client's slot is freed
+		double timeout = 5.0;
+		// Play the slots nobody has joined with bots
+		bool bots = false;
+	};
+
+	struct stats {
+		uint64_t ticks = 0;
+		uint64_t clients = 0;
+		uint64_t datagrams_received = 0;
+		uint64_t datagrams_rejected = 0;
+		uint64_t bytes_sent = 0;
+		uint64_t full_snapshots = 0;
+		uint64_t delta_snapshots = 0;
+		// Snapshots too big for a datagram, never sent
+		uint64_t oversized = 0;
+		// Wall time of simulating and encoding every match, in total and the worst tick
+		double tick_seconds = 0;
+		double max_tick_seconds = 0;
+	};
+
+	Match_Server(const settings& config, uint16_t port);
+	~Match_Server();
+
+	bool is_open() const {
+		return socket.is_open();
+	}
+	uint16_t get_port() const {
+		return socket.get_port();
+	}
+
+	// Reads every waiting datagram, then plays one tick of every match and sends the
+	// snapshots. now is in seconds on any clock, it is only used for timeouts.
+	void tick(double now);
+
+	float get_step() const {
+		return step;
+	}
+	const stats& get_stats() const {
+		return counters;
+	}
+
+  private:
+	struct slot_state {
+		bool occupied = false;
+		Udp_Socket::address client;
+		// Newest tick the client has a view of, -1 for none
+		int64_t acked = -1;
+		uint32_t packed = 0;
+		double heard = 0;
+	};
+
+	struct outgoing {
+		Udp_Socket::address to;
+		std::vector<uint8_t> bytes;
+		bool full;
+	};
+
+	struct match_state {
+		std::unique_ptr<game::World> world;
+		Bot_Fields bot_fields;
+		std::array<slot_state, control::max_players> slots;
+		// Views by tick modulo net::history
+		std::array<net::view, net::history> views;
+		Bit_Writer writer;
+		std::vector<outgoing> outbox;
+	};
+
+	// Where a client plays
+	struct seat {
+		std::size_t match;
+		std::size_t slot;
+	};
+
+	void read_datagram(const Udp_Socket::address& from, const uint8_t* data, std::size_t size,
+	                   double now);
+	void welcome(const Udp_Socket::address& to, const seat& place);
+	void drop_idle(double now);
+	void play(match_state& match);
+
+	settings config;
+	float step;
+	Udp_Socket socket;
+	Thread_Pool pool;
+	std::vector<match_state> matches;
+	std::unordered_map<uint64_t, seat> seats;
+	std::vector<uint8_t> datagram;
+	Bit_Writer packet;
+	stats counters;
+};
@@ -1,5 +1,6 @@
 #include <GL/glew.h>
 
+#include "gl_state.hpp"
 #include "shader.hpp"
 #include "util.hpp"
 
@@ -85,10 +86,15 @@ void Shader_Program::link() {
 	}
 
 	shaders.clear();
+
+	auto frame = glGetUniformBlockIndex(this->program, Shader::frame_block);
+	if (frame != GL_INVALID_INDEX) {
+		glUniformBlockBinding(this->program, frame, Shader::frame_binding);
+	}
 }
 
 void Shader_Program::use() {
-	glUseProgram(this->program);
+	gl_state::use_program(this->program);
 }
 
 GLuint Shader_Program::getUniform(const char* uniform_name, Shader::throwonfail_t should_throw) {
@@ -6,6 +6,10 @@
 namespace Shader {
 	enum shadertype_t { VERTEX, GEOMETRY, TESS_C, TESS_E, FRAGMENT, COMPUTE };
 	enum throwonfail_t { MANDITORY = 1, OPTIONAL = 0};
+
+	// Uniform block every program that declares it is linked to, see render::frame_uniforms
+	constexpr const char* frame_block = "Frame";
+	constexpr GLuint frame_binding = 0;
 }
 
 class Shader_Program {
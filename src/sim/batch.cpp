@@ -0,0 +1,167 @@
+#include "batch.hpp"
+
+#include "core/bot.hpp"
+#include "core/game.hpp"
+#include "core/replay.hpp"
+#include "core/search_bot.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <ostream>
+
+control::movement_report_type batch::random_report(std::mt19937& prng, std::size_t players) {
+	std::uniform_int_distribution<int> dir_uid(0, 4);
+	std::bernoulli_distribution trigger_bd(0.1);
+
+	control::movement_report_type report = {};
+	for (std::size_t i = 0; i < std::min(players, report.size()); ++i) {
+		auto&& controller = report[i];
+		controller.left_stick_dir = static_cast<control::controller_report::direction>(dir_uid(prng));
+		controller.right_stick_dir = control::controller_report::direction::none;
+		controller.keys = {{false}};
+		controller.active = true;
+		controller.ltrigger = trigger_bd(prng);
+		controller.rtrigger = trigger_bd(prng);
+	}
+
+	return report;
+}
+
+batch::match_result batch::run_match(const match_settings& settings, uint32_t seed,
+                                     const std::string& replay_path) {
+	// Worlds are a few hundred KB, too big for a worker thread's stack
+	auto world_storage = std::make_unique<game::World>();
+	auto&& world = *world_storage;
+	game::initialize(world, settings.width, settings.height, seed);
+
+	// Inputs come from their own generator so they don't shift the map's random stream
+	std::mt19937 input_prng(seed ^ 0x9E3779B9u);
+
+	const float time_step = 1.0f / settings.tick_rate;
+	const auto match_ticks = static_cast<uint64_t>(settings.length * settings.tick_rate);
+
+	const auto slots = std::min(settings.players, control::max_players);
+	std::ofstream replay_file;
+	std::unique_ptr<Replay_Recorder> recorder;
+	if (!replay_path.empty()) {
+		replay_file.open(replay_path, std::ios::binary);
+		replay::header info;
+		info.seed = seed;
+		info.width = static_cast<uint32_t>(world.grid.width);
+		info.height = static_cast<uint32_t>(world.grid.height);
+		info.step = time_step;
+		info.players = static_cast<uint32_t>(slots);
+		recorder = std::make_unique<Replay_Recorder>(replay_file, info);
+	}
+
+	match_result result;
+	std::unique_ptr<Bot_Fields> fields;
+	if (settings.bots > 0) {
+		fields = std::make_unique<Bot_Fields>();
+	}
+	const auto first_bot = slots - std::min(settings.bots, slots);
+	const auto first_search = std::max(slots - std::min(settings.search, slots), first_bot);
+	std::unique_ptr<Search_Bot> searcher;
+	if (first_search < slots) {
+		Search_Bot::settings search_settings;
+		search_settings.budget = settings.search_budget;
+		search_settings.threads = settings.search_threads;
+		search_settings.seed = seed;
+		searcher = std::make_unique<Search_Bot>(search_settings);
+	}
+
+	for (uint64_t tick = 0; tick < match_ticks; ++tick) {
+		auto report = random_report(input_prng, slots);
+		if (fields) {
+			auto start = std::chrono::steady_clock::now();
+			fields->update(world);
+			auto decided = std::chrono::steady_clock::now();
+			for (auto slot = first_bot; slot < first_search; ++slot) {
+				report[slot] = bot::decide(world, *fields, slot);
+			}
+			for (auto slot = first_search; slot < slots; ++slot) {
+				report[slot] = searcher->decide(world, slot);
+			}
+			auto end = std::chrono::steady_clock::now();
+			result.field_seconds += std::chrono::duration<double>(decided - start).count();
+			result.decide_seconds += std::chrono::duration<double>(end - decided).count();
+			result.bot_decisions += slots - first_bot;
+		}
+		if (recorder) {
+			recorder->record(world, report);
+		}
+		game::update(world, report, time_step);
+	}
+
+	if (searcher) {
+		auto&& searched = searcher->get_stats();
+		result.search_decisions = searched.decisions;
+		result.playouts = searched.playouts;
+		result.search_states = searched.states;
+		result.search_seconds = searched.worker_seconds;
+	}
+	if (recorder) {
+		recorder->finish(world);
+		result.replay_bytes = recorder->get_byte_count();
+	}
+	result.seed = seed;
+	result.players = slots;
+	result.ticks = match_ticks;
+	result.bullet_peak = world.bullets.entities.get_high_water();
+	result.bomb_peak = world.bombs.entities.get_high_water();
+	result.bullet_failures = world.bullets.entities.get_spawn_failures();
+	result.bomb_failures = world.bombs.entities.get_spawn_failures();
+	result.kills = world.kills;
+	result.deaths = world.deaths;
+
+	auto played = world.kills.begin() + static_cast<std::ptrdiff_t>(slots);
+	auto best = std::max_element(world.kills.begin(), played);
+	if (std::count(world.kills.begin(), played, *best) == 1) {
+		result.winner = static_cast<std::size_t>(best - world.kills.begin());
+	}
+	else {
+		result.winner = no_winner;
+	}
+
+	return result;
+}
+
+void batch::accumulate(batch_stats& stats, const match_result& result) {
+	stats.matches += 1;
+	stats.players = std::max(stats.players, result.players);
+	stats.ticks += result.ticks;
+	stats.replay_bytes += result.replay_bytes;
+	stats.field_seconds += result.field_seconds;
+	stats.decide_seconds += result.decide_seconds;
+	stats.bot_decisions += result.bot_decisions;
+	stats.search_decisions += result.search_decisions;
+	stats.playouts += result.playouts;
+	stats.search_states += result.search_states;
+	stats.search_seconds += result.search_seconds;
+	stats.bullet_peak = std::max(stats.bullet_peak, result.bullet_peak);
+	stats.bomb_peak = std::max(stats.bomb_peak, result.bomb_peak);
+	stats.bullet_failures += result.bullet_failures;
+	stats.bomb_failures += result.bomb_failures;
+	if (result.winner == no_winner) {
+		stats.draws += 1;
+	}
+	else {
+		stats.wins[result.winner] += 1;
+	}
+	for (std::size_t i = 0; i < control::max_players; ++i) {
+		stats.kills[i] += result.kills[i];
+		stats.deaths[i] += result.deaths[i];
+	}
+}
+
+void batch::write_stats(std::ostream& out, const batch_stats& stats) {
+	out << "slot,wins,kills,deaths\n";
+	for (std::size_t i = 0; i < stats.players; ++i) {
+		out << i << ',' << stats.wins[i] << ',' << stats.kills[i] << ',' << stats.deaths[i]
+		    << '\n';
+	}
+	out << "draws," << stats.draws << ",,\n";
+	out << "matches," << stats.matches << ",,\n";
+}
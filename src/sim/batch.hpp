@@ -0,0 +1,86 @@
+#pragma once
+
+#include "core/controller_report.hpp"
+
+#include <array>
+#include <cinttypes>
+#include <cstddef>
+#include <iosfwd>
+#include <random>
+#include <string>
+
+namespace batch {
+	struct match_settings {
+		std::size_t width = 11;
+		std::size_t height = 11;
+		float length = 120.0f;
+		float tick_rate = 120.0f;
+		// Slots played, from the first one. The rest stay empty.
+		std::size_t players = 4;
+		// The last this many slots are played by bots instead of random inputs
+		std::size_t bots = 0;
+		// The last this many of the bots search instead, with a budget in seconds per move
+		std::size_t search = 0;
+		double search_budget = 0.002;
+		std::size_t search_threads = 1;
+	};
+
+	struct match_result {
+		uint32_t seed;
+		uint64_t ticks;
+		std::size_t players;
+		std::array<uint32_t, control::max_players> kills;
+		std::array<uint32_t, control::max_players> deaths;
+		// Slot with the most kills, no_winner on a tie
+		std::size_t winner;
+		// Size of the replay file, 0 when not recording
+		uint64_t replay_bytes = 0;
+		// Time spent updating bot fields and deciding, and the decisions made
+		double field_seconds = 0;
+		double decide_seconds = 0;
+		uint64_t bot_decisions = 0;
+		// Searches run, their playouts and simulated ticks, and the time spent on them
+		uint64_t search_decisions = 0;
+		uint64_t playouts = 0;
+		uint64_t search_states = 0;
+		double search_seconds = 0;
+		// Most bullets and bombs alive at once, and spawns refused by full pools
+		uint32_t bullet_peak = 0;
+		uint32_t bomb_peak = 0;
+		uint64_t bullet_failures = 0;
+		uint64_t bomb_failures = 0;
+	};
+
+	struct batch_stats {
+		std::size_t matches = 0;
+		std::size_t draws = 0;
+		// Slots played in the biggest match
+		std::size_t players = 0;
+		uint64_t ticks = 0;
+		uint64_t replay_bytes = 0;
+		double field_seconds = 0;
+		double decide_seconds = 0;
+		uint64_t bot_decisions = 0;
+		uint64_t search_decisions = 0;
+		uint64_t playouts = 0;
+		uint64_t search_states = 0;
+		double search_seconds = 0;
+		uint32_t bullet_peak = 0;
+		uint32_t bomb_peak = 0;
+		uint64_t bullet_failures = 0;
+		uint64_t bomb_failures = 0;
+		std::array<uint64_t, control::max_players> wins = {};
+		std::array<uint64_t, control::max_players> kills = {};
+		std::array<uint64_t, control::max_players> deaths = {};
+	};
+
+	constexpr std::size_t no_winner = control::max_players;
+
+	// Random inputs for the first players slots, the others are left inactive
+	control::movement_report_type random_report(std::mt19937& prng, std::size_t players);
+	// Records a replay to replay_path unless it is empty
+	match_result run_match(const match_settings& settings, uint32_t seed,
+	                       const std::string& replay_path = "");
+	void accumulate(batch_stats& stats, const match_result& result);
+	void write_stats(std::ostream& out, const batch_stats& stats);
+}
@@ -0,0 +1,235 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "batch.hpp"
+#include "netplay.hpp"
+#include "core/game.hpp"
+#include "core/replay.hpp"
+#include "core/thread_pool.hpp"
+
+static void print_usage() {
+	std::cerr << "Usage: bomberman_sim [--matches N] [--length seconds] [--tick-rate hz]\n"
+	             "                     [--size WxH] [--threads N] [--seed N] [--stats file]\n"
+	             "                     [--record directory] [--players N] [--bots N]\n"
+	             "                     [--search N] [--budget ms] [--search-threads N]\n"
+	             "       bomberman_sim --replay file\n"
+	             "       bomberman_sim --netplay peers [--latency ms] [--jitter ms] [--loss %]\n"
+	             "                     [--input-delay ticks] [--rollback ticks]\n"
+	             "                     [--transport memory|udp] [--length seconds]\n"
+	             "                     [--tick-rate hz] [--size WxH] [--seed N]\n";
+}
+
+// Plays a replay to the end, checks it ends on the recorded world, then times seeks
+static int play_replay(const std::string& path) {
+	std::ifstream in(path, std::ios::binary);
+	Replay_Player player;
+	if (!in.is_open() || !player.load(in)) {
+		std::cerr << "Can't read replay " << path << '\n';
+		return 1;
+	}
+
+	auto world_storage = std::make_unique<game::World>();
+	auto&& world = *world_storage;
+	auto start = std::chrono::steady_clock::now();
+	player.seek(world, 0);
+	while (player.step(world)) {
+	}
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	bool matches = player.verify(world);
+
+	std::cout << "Replay: " << player.get_position() << " ticks in " << elapsed.count()
+	          << "s, seed " << player.get_header().seed << ", "
+	          << (matches ? "matches the recording" : "DOES NOT match the recording") << '\n';
+	std::cout << "slot,kills,deaths\n";
+	for (std::size_t i = 0; i < world.kills.size(); ++i) {
+		if (!world.players.active[i]) {
+			continue;
+		}
+		std::cout << i << ',' << world.kills[i] << ',' << world.deaths[i] << '\n';
+	}
+
+	for (auto target : {player.get_tick_count() / 2, player.get_tick_count() - 1}) {
+		auto seek_start = std::chrono::steady_clock::now();
+		player.seek(world, target);
+		std::chrono::duration<double> seek_time = std::chrono::steady_clock::now() - seek_start;
+		std::cout << "Seek to " << target << ": " << seek_time.count() * 1000.0 << "ms\n";
+	}
+
+	return matches ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+	std::size_t match_count = 1000;
+	std::size_t thread_count = std::thread::hardware_concurrency();
+	uint32_t base_seed = std::random_device{}();
+	std::string stats_file;
+	std::string record_directory;
+	batch::match_settings settings;
+	netplay::harness_settings net;
+	bool run_netplay = false;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (i + 1 >= argc) {
+			print_usage();
+			return 1;
+		}
+		std::string value = argv[++i];
+
+		if (arg == "--matches") {
+			match_count = std::stoul(value);
+		}
+		else if (arg == "--length") {
+			settings.length = std::stof(value);
+		}
+		else if (arg == "--tick-rate") {
+			settings.tick_rate = std::stof(value);
+		}
+		else if (arg == "--size") {
+			settings.width = std::stoul(value);
+			auto split = value.find('x');
+			settings.height = split == std::string::npos ? settings.width
+			                                             : std::stoul(value.substr(split + 1));
+		}
+		else if (arg == "--threads") {
+			thread_count = std::stoul(value);
+		}
+		else if (arg == "--seed") {
+			base_seed = static_cast<uint32_t>(std::stoul(value));
+		}
+		else if (arg == "--stats") {
+			stats_file = value;
+		}
+		else if (arg == "--players") {
+			settings.players = std::stoul(value);
+		}
+		else if (arg == "--bots") {
+			settings.bots = std::stoul(value);
+		}
+		else if (arg == "--search") {
+			settings.search = std::stoul(value);
+		}
+		else if (arg == "--budget") {
+			settings.search_budget = std::stod(value) / 1000.0;
+		}
+		else if (arg == "--search-threads") {
+			settings.search_threads = std::stoul(value);
+		}
+		else if (arg == "--record") {
+			record_directory = value;
+		}
+		else if (arg == "--replay") {
+			return play_replay(value);
+		}
+		else if (arg == "--netplay") {
+			run_netplay = true;
+			net.peers = std::stoul(value);
+		}
+		else if (arg == "--latency") {
+			net.link.latency = std::stof(value) / 1000.0f;
+		}
+		else if (arg == "--jitter") {
+			net.link.jitter = std::stof(value) / 1000.0f;
+		}
+		else if (arg == "--loss") {
+			net.link.loss = std::stof(value) / 100.0f;
+		}
+		else if (arg == "--input-delay") {
+			net.input_delay = static_cast<uint32_t>(std::stoul(value));
+		}
+		else if (arg == "--rollback") {
+			net.max_rollback = static_cast<uint32_t>(std::stoul(value));
+		}
+		else if (arg == "--transport") {
+			net.udp = value == "udp";
+		}
+		else {
+			print_usage();
+			return 1;
+		}
+	}
+
+	settings.players = std::min(std::max<std::size_t>(settings.players, 1), control::max_players);
+	settings.bots = std::max(settings.bots, settings.search);
+
+	if (run_netplay) {
+		net.match = settings;
+		net.seed = base_seed;
+		return netplay::run(net, std::cout) ? 0 : 1;
+	}
+
+	// Every match writes to its own slot, so tasks never share anything
+	std::vector<batch::match_result> results(match_count);
+
+	auto start = std::chrono::steady_clock::now();
+	{
+		Thread_Pool pool(thread_count);
+		thread_count = pool.size();
+		for (std::size_t match = 0; match < match_count; ++match) {
+			pool.submit([&, match] {
+				auto seed = base_seed + static_cast<uint32_t>(match);
+				std::string replay_path;
+				if (!record_directory.empty()) {
+					replay_path = record_directory + "/match_" + std::to_string(seed) + ".bmr";
+				}
+				results[match] = batch::run_match(settings, seed, replay_path);
+			});
+		}
+		pool.wait();
+	}
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	batch::batch_stats stats;
+	for (auto&& result : results) {
+		batch::accumulate(stats, result);
+	}
+
+	std::cout << "Matches: " << stats.matches << " - " << stats.ticks << " ticks in "
+	          << elapsed.count() << "s on " << thread_count << " threads (seed " << base_seed
+	          << ")\n";
+	std::cout << "Matches/s: " << static_cast<double>(stats.matches) / elapsed.count() << " - "
+	          << "Ticks/s: " << static_cast<double>(stats.ticks) / elapsed.count() << '\n';
+
+	if (stats.replay_bytes > 0) {
+		std::cout << "Replays: " << stats.replay_bytes << " bytes - "
+		          << static_cast<double>(stats.replay_bytes) / static_cast<double>(stats.ticks)
+		          << " bytes/tick\n";
+	}
+
+	std::cout << "Pools: bullets peaked at " << stats.bullet_peak << '/' << bullet::max_bullets
+	          << " with " << stats.bullet_failures << " dropped, bombs at " << stats.bomb_peak
+	          << '/' << bomb::max_bombs << " with " << stats.bomb_failures << " dropped\n";
+
+	if (stats.bot_decisions > 0) {
+		std::cout << "Bots: " << stats.field_seconds / static_cast<double>(stats.ticks) * 1e6
+		          << "us per tick on fields, "
+		          << stats.decide_seconds / static_cast<double>(stats.bot_decisions) * 1e6
+		          << "us per decision\n";
+	}
+	if (stats.search_decisions > 0) {
+		auto decisions = static_cast<double>(stats.search_decisions);
+		std::cout << "Search: " << static_cast<double>(stats.playouts) / decisions
+		          << " playouts per move, "
+		          << static_cast<double>(stats.search_states) / stats.search_seconds
+		          << " states/s per core\n";
+	}
+
+	batch::write_stats(std::cout, stats);
+	if (!stats_file.empty()) {
+		std::ofstream out(stats_file);
+		if (!out.is_open()) {
+			std::cerr << "Can't open " << stats_file << '\n';
+			return 1;
+		}
+		batch::write_stats(out, stats);
+	}
+
+	return 0;
+}
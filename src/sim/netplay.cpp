@@ -0,0 +1,217 @@
+#include "netplay.hpp"
+
+#include "core/game.hpp"
+#include "core/replay.hpp"
+#include "core/rollback.hpp"
+#include "core/udp_socket.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <ostream>
+#include <random>
+#include <vector>
+
+struct peer {
+	std::unique_ptr<game::World> world;
+	std::unique_ptr<Rollback_Session> session;
+	std::unique_ptr<Udp_Socket> socket;
+	std::mt19937 prng;
+	control::controller_report input;
+	// Packed local input by the tick it is played on, for the reference simulation
+	std::vector<uint32_t> played;
+};
+
+struct datagram {
+	double deliver_at;
+	std::size_t from, to;
+	std::vector<uint8_t> bytes;
+};
+
+// Holds a stick direction for a while like a person does, so predictions are right
+// most of the time. A new input every tick would roll back on every datagram.
+static void next_input(peer& p, std::size_t slot) {
+	std::bernoulli_distribution change(1.0 / 12.0);
+	if (change(p.prng)) {
+		p.input = batch::random_report(p.prng, slot + 1)[slot];
+	}
+}
+
+// Checksums of a single world given every peer's inputs directly
+static std::vector<uint64_t> reference_checksums(const netplay::harness_settings& settings,
+                                                 const std::vector<peer>& peers,
+                                                 uint32_t ticks) {
+	auto world = std::make_unique<game::World>();
+	game::initialize(*world, settings.match.width, settings.match.height, settings.seed);
+	const float step = 1.0f / settings.match.tick_rate;
+
+	control::controller_report idle = replay::unpack_report(0);
+	idle.active = true;
+
+	std::vector<uint64_t> sums;
+	for (uint32_t t = 0; t < ticks; ++t) {
+		sums.push_back(replay::checksum(*world));
+		control::movement_report_type report;
+		for (std::size_t s = 0; s < report.size(); ++s) {
+			if (s >= peers.size()) {
+				report[s] = replay::unpack_report(0);
+			}
+			else if (t < settings.input_delay) {
+				report[s] = idle;
+			}
+			else {
+				report[s] = replay::unpack_report(peers[s].played[t]);
+			}
+		}
+		game::update(*world, report, step);
+	}
+	sums.push_back(replay::checksum(*world));
+	return sums;
+}
+
+bool netplay::run(const harness_settings& settings, std::ostream& out) {
+	const float step = 1.0f / settings.match.tick_rate;
+	const auto ticks = static_cast<uint32_t>(settings.match.length * settings.match.tick_rate);
+	const auto peer_count =
+	    std::min(std::max<std::size_t>(settings.peers, 2), control::max_players);
+
+	std::vector<peer> peers(peer_count);
+	for (std::size_t i = 0; i < peer_count; ++i) {
+		auto&& p = peers[i];
+		p.world = std::make_unique<game::World>();
+		game::initialize(*p.world, settings.match.width, settings.match.height, settings.seed);
+
+		Rollback_Session::settings config;
+		config.local_slot = i;
+		config.player_count = peer_count;
+		config.input_delay = settings.input_delay;
+		config.max_rollback = settings.max_rollback;
+		config.sync_checks = true;
+		p.session = std::make_unique<Rollback_Session>(*p.world, step, config);
+
+		p.prng.seed(settings.seed + static_cast<uint32_t>(i) * 7919u);
+		p.input = batch::random_report(p.prng, i + 1)[i];
+		p.played.assign(ticks + settings.input_delay, 0);
+
+		if (settings.udp) {
+			p.socket = std::make_unique<Udp_Socket>();
+			if (!p.socket->is_open()) {
+				out << "Can't open a UDP socket\n";
+				return false;
+			}
+		}
+	}
+
+	std::mt19937 link_prng(settings.seed ^ 0x5BD1E995u);
+	std::bernoulli_distribution lost(settings.link.loss);
+	std::uniform_real_distribution<double> jitter(-settings.link.jitter, settings.link.jitter);
+	std::vector<datagram> in_flight;
+	uint64_t sent = 0, dropped = 0;
+	Bit_Writer packet;
+	std::vector<uint8_t> buffer(2048);
+
+	auto finished = [&] {
+		return std::all_of(peers.begin(), peers.end(), [&](const peer& p) {
+			return p.session->get_frame() >= ticks &&
+			       p.session->get_confirmed() + 1 >= static_cast<int64_t>(ticks) &&
+			       p.session->get_checksums().size() > ticks;
+		});
+	};
+
+	// Peers that are done keep running so the others get their acks and inputs
+	const uint64_t frame_limit = uint64_t(ticks) * 4 + 1000;
+	uint64_t frame = 0;
+	for (; frame < frame_limit && !finished(); ++frame) {
+		double now = static_cast<double>(frame) * step;
+
+		auto due = std::stable_partition(in_flight.begin(), in_flight.end(),
+		                                 [&](const datagram& d) { return d.deliver_at > now; });
+		for (auto it = due; it != in_flight.end(); ++it) {
+			if (settings.udp) {
+				auto to = Udp_Socket::loopback(peers[it->to].socket->get_port());
+				peers[it->from].socket->send(to, it->bytes.data(), it->bytes.size());
+			}
+			else {
+				peers[it->to].session->read_packet(it->bytes.data(), it->bytes.size());
+			}
+		}
+		in_flight.erase(due, in_flight.end());
+
+		for (std::size_t i = 0; i < peer_count; ++i) {
+			auto&& p = peers[i];
+			if (settings.udp) {
+				Udp_Socket::address from;
+				while (auto size = p.socket->receive(from, buffer.data(), buffer.size())) {
+					p.session->read_packet(buffer.data(), size);
+				}
+			}
+
+			if (p.session->get_frame() < ticks) {
+				next_input(p, i);
+				auto tick = p.session->get_frame() + settings.input_delay;
+				if (p.session->advance(p.input)) {
+					auto played = p.input;
+					played.active = true;
+					p.played[tick] = replay::pack_report(played);
+				}
+			}
+			else {
+				p.session->synchronize();
+			}
+
+			for (std::size_t to = 0; to < peer_count; ++to) {
+				if (to == i) {
+					continue;
+				}
+				p.session->write_packet(to, packet);
+				sent += 1;
+				if (lost(link_prng)) {
+					dropped += 1;
+					continue;
+				}
+				auto delay = std::max(0.0, settings.link.latency + jitter(link_prng));
+				in_flight.push_back(datagram{now + delay, i, to, packet.finish()});
+			}
+		}
+	}
+
+	auto reference = reference_checksums(settings, peers, ticks);
+
+	out << "Netplay: " << peer_count << " peers over " << (settings.udp ? "udp" : "memory")
+	    << ", " << ticks << " ticks in " << frame << " frames - latency "
+	    << settings.link.latency * 1000 << "ms, jitter " << settings.link.jitter * 1000
+	    << "ms, loss " << settings.link.loss * 100 << "% (" << dropped << " of " << sent
+	    << " datagrams dropped)\n";
+	out << "peer,frames,stalls,rollbacks,avg_depth,max_depth,resim_ticks/frame,"
+	       "resim_us/frame,max_resim_us\n";
+
+	bool converged = true;
+	for (std::size_t i = 0; i < peer_count; ++i) {
+		auto&& stats = peers[i].session->get_stats();
+		auto frames = static_cast<double>(std::max<uint64_t>(stats.frames, 1));
+		auto rollbacks = static_cast<double>(std::max<uint64_t>(stats.rollbacks, 1));
+		out << i << ',' << stats.frames << ',' << stats.stalls << ',' << stats.rollbacks << ','
+		    << static_cast<double>(stats.resimulated) / rollbacks << ',' << stats.max_depth
+		    << ',' << static_cast<double>(stats.resimulated) / frames << ','
+		    << stats.resimulate_seconds * 1e6 / frames << ','
+		    << stats.max_frame_seconds * 1e6 << '\n';
+
+		auto&& sums = peers[i].session->get_checksums();
+		if (sums.size() <= ticks) {
+			out << "Peer " << i << " only confirmed " << sums.size() << " ticks\n";
+			converged = false;
+			continue;
+		}
+		for (uint32_t t = 0; t <= ticks; ++t) {
+			if (sums[t] != reference[t]) {
+				out << "Peer " << i << " diverged at tick " << t << '\n';
+				converged = false;
+				break;
+			}
+		}
+	}
+
+	out << (converged ? "Converged: every peer matches the reference on all "
+	                  : "NOT converged, compared ")
+	    << ticks + 1 << " ticks\n";
+	return converged;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "batch.hpp"
+
+#include <cinttypes>
+#include <cstddef>
+#include <iosfwd>
+
+// Loopback harness for rollback sessions. Every peer runs in this process on a shared
+// virtual clock, and datagrams between them go through a link that delays, jitters
+// and drops them. With the udp transport the datagrams that survive the link are
+// then sent over real sockets on localhost.
+namespace netplay {
+	struct link_settings {
+		// Seconds, one way
+		float latency = 0.05f;
+		float jitter = 0.01f;
+		// Fraction of datagrams dropped
+		float loss = 0.05f;
+	};
+
+	struct harness_settings {
+		batch::match_settings match;
+		std::size_t peers = 2;
+		link_settings link;
+		uint32_t input_delay = 2;
+		uint32_t max_rollback = 8;
+		bool udp = false;
+		uint32_t seed = 0;
+	};
+
+	// Plays a match on every peer, then checks each peer's confirmed world against the
+	// others and against a plain simulation of the same inputs. Writes the rollback
+	// stats of each peer, returns whether everything matched.
+	bool run(const harness_settings& settings, std::ostream& out);
+}
@@ -0,0 +1,133 @@
+#include "stream_buffer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <vector>
+
+static constexpr std::size_t initial_region = 1 << 20;
+
+static GLuint buffer = 0;
+static bool created = false;
+static bool persistent = false;
+static unsigned char* mapped = nullptr;
+static std::size_t region_size = 0;
+static std::size_t alignment = 256;
+
+// Region being written, and how far into it
+static std::size_t region = 0;
+static std::size_t used = 0;
+static std::array<GLsync, stream_buffer::frames_in_flight> fences = {};
+
+// Buffers replaced by a bigger one this frame. Bindings made earlier in the frame
+// still point at them, so they go at the start of the next one.
+static std::vector<GLuint> retired;
+
+static stream_buffer::stats counting, last_frame;
+
+static std::size_t round_up(std::size_t value, std::size_t multiple) {
+	return (value + multiple - 1) / multiple * multiple;
+}
+
+static void allocate(std::size_t size) {
+	region_size = round_up(size, alignment);
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+	if (persistent) {
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		auto total = static_cast<GLsizeiptr>(region_size * stream_buffer::frames_in_flight);
+		glBufferStorage(GL_COPY_WRITE_BUFFER, total, nullptr, flags);
+		mapped = static_cast<unsigned char*>(
+		    glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, total, flags));
+	}
+	else {
+		glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(region_size), nullptr,
+		             GL_STREAM_DRAW);
+	}
+}
+
+static void create() {
+	GLint uniform_alignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniform_alignment);
+	alignment = std::max<std::size_t>(static_cast<std::size_t>(uniform_alignment), 16);
+	persistent = GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+	allocate(initial_region);
+	created = true;
+}
+
+// Swaps in a buffer whose regions hold at least size bytes. Only the frame being
+// written moves over, regions of frames in flight stay with the old buffer.
+static void grow(std::size_t size) {
+	retired.push_back(buffer);
+	if (persistent) {
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+		glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+		mapped = nullptr;
+	}
+	allocate(std::max(size, region_size * 2));
+	used = 0;
+	counting.grows += 1;
+}
+
+void stream_buffer::begin_frame() {
+	if (!created) {
+		create();
+	}
+	if (!retired.empty()) {
+		glDeleteBuffers(static_cast<GLsizei>(retired.size()), retired.data());
+		retired.clear();
+	}
+
+	used = 0;
+	if (!persistent) {
+		// Orphans last frame's storage rather than waiting for the GPU to finish with it
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+		glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(region_size), nullptr,
+		             GL_STREAM_DRAW);
+		return;
+	}
+
+	region = (region + 1) % frames_in_flight;
+	auto&& fence = fences[region];
+	if (fence) {
+		if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+			counting.stalls += 1;
+			while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) ==
+			       GL_TIMEOUT_EXPIRED) {
+			}
+		}
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+}
+
+stream_buffer::range stream_buffer::push(const void* data, std::size_t bytes) {
+	if (used + bytes > region_size) {
+		grow(used + bytes);
+	}
+	auto offset = (persistent ? region * region_size : 0) + used;
+	if (persistent) {
+		std::memcpy(mapped + offset, data, bytes);
+	}
+	else {
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+		glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(offset),
+		                static_cast<GLsizeiptr>(bytes), data);
+	}
+	used = std::min(round_up(used + bytes, alignment), region_size);
+	counting.bytes += bytes;
+	return range{buffer, offset};
+}
+
+void stream_buffer::end_frame() {
+	if (persistent) {
+		fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+	counting.persistent = persistent;
+	last_frame = counting;
+	counting = stats{};
+}
+
+const stream_buffer::stats& stream_buffer::get_stats() {
+	return last_frame;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <cstddef>
+
+// One buffer every frame's dynamic data is written into: instance matrices, light data
+// and the Frame uniform block. Where GL 4.4 or ARB_buffer_storage is there it is mapped
+// once, persistently and coherently, and split into a region per frame in flight. A
+// fence placed at the end of each frame guards its region, so writing into a region
+// only waits when the GPU is still reading it three frames later. Without buffer
+// storage the buffer is orphaned at the start of each frame and written with
+// glBufferSubData.
+namespace stream_buffer {
+	// Frames the GPU can be behind before writing waits for it
+	constexpr std::size_t frames_in_flight = 3;
+
+	// Where pushed data went. The buffer can change when a frame outgrows its region,
+	// bind the one returned rather than keeping it.
+	struct range {
+		GLuint buffer;
+		std::size_t offset;
+	};
+
+	// Moves on to the next region, waiting for the GPU if it is still reading it. Call
+	// before anything is pushed in a frame.
+	void begin_frame();
+	// Copies data into the frame's region. Every push starts at an offset uniform
+	// blocks can be bound at.
+	range push(const void* data, std::size_t bytes);
+	// Fences the frame's region, call after the frame's last draw
+	void end_frame();
+
+	struct stats {
+		std::size_t bytes = 0;
+		// Times begin_frame() had to wait for the GPU, and regions made bigger because a
+		// frame didn't fit
+		std::size_t stalls = 0;
+		std::size_t grows = 0;
+		bool persistent = false;
+	};
+	// Counts of the last frame ended
+	const stats& get_stats();
+}
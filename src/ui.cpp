@@ -1,4 +1,5 @@
 #include "ui.hpp"
+#include "gl_state.hpp"
 #include "image.hpp"
 #include "player.hpp"
 #include "render.hpp"
@@ -27,6 +28,37 @@ static GLuint choose_tex(std::size_t ammo_count) {
 	}
 }
 
+// Where a slot's ammo count and bomb icon go, in pixels from the bottom left. Slots go
+// round the corners clockwise from the top left, the bomb icon on the inside, and
+// later slots line up next to the earlier ones in their corner towards the middle.
+// Everything is scaled down once a row no longer fits in half the screen.
+struct hud_place {
+	float ammo_x, bomb_x, y;
+};
+
+// Width of one slot's entry in a row
+static constexpr float hud_entry = 170.0f;
+
+static float hud_scale(const game::World& world, float width) {
+	std::size_t used = 0;
+	for (std::size_t i = 0; i < world.players.size(); ++i) {
+		used = world.players.active[i] ? i + 1 : used;
+	}
+	auto row = static_cast<float>((used + 3) / 4) * hud_entry;
+	return row > width / 2.0f ? width / 2.0f / row : 1.0f;
+}
+
+static hud_place hud_corner(std::size_t slot, float width, float height, float scale) {
+	bool right = slot % 4 == 1 || slot % 4 == 2;
+	bool top = slot % 4 < 2;
+	float y = top ? height - 110.0f * scale : 0.0f;
+	float inward = static_cast<float>(slot / 4) * hud_entry;
+	if (right) {
+		return hud_place{width - (50.0f + inward) * scale, width - (160.0f + inward) * scale, y};
+	}
+	return hud_place{(10.0f + inward) * scale, (60.0f + inward) * scale, y};
+}
+
 void ui::initialize() {
 	image::image ammo_image_0 = image::create_ogl_image("textures/ammo0.png");
 	image::image ammo_image_1 = image::create_ogl_image("textures/ammo1.png");
@@ -54,98 +86,44 @@ void ui::initialize() {
 	glUniform1i(image_prog->getUniform("textTexture"), 0);
 }
 
-void ui::render(std::size_t screen_width, std::size_t screen_height) {
-	glEnable(GL_BLEND);
+void ui::render(const game::World& world, std::size_t screen_width, std::size_t screen_height) {
+	auto&& ps = world.players;
+
+	gl_state::set_enabled(GL_BLEND, true);
 	glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE);
 
 	image_prog->use();
 
-	glUniform2f(image_prog->getUniform("size"), 40.0f / float(screen_width),
-	            100.0f / float(screen_height));
-
-	if (players::player_list[0].active) {
-		glUniform2f(image_prog->getUniform("origin"), 10.0f / float(screen_width),
-		            (float(screen_height) - 110.0f) / float(screen_height));
-
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, choose_tex(players::player_list[0].ammo_count));
-
-		render::render_fullscreen_quad();
-	}
-
-	if (players::player_list[1].active) {
-		glUniform2f(image_prog->getUniform("origin"),
-		            (float(screen_width) - 50.f) / float(screen_width),
-		            (float(screen_height) - 110.0f) / float(screen_height));
-
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, choose_tex(players::player_list[1].ammo_count));
-
-		render::render_fullscreen_quad();
-	}
-
-	if (players::player_list[2].active) {
-		glUniform2f(image_prog->getUniform("origin"),
-		            (float(screen_width) - 50.f) / float(screen_width), 0);
-
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, choose_tex(players::player_list[2].ammo_count));
-
+	auto width = float(screen_width);
+	auto height = float(screen_height);
+	auto scale = hud_scale(world, width);
+
+	glUniform2f(image_prog->getUniform("size"), 40.0f * scale / width, 100.0f * scale / height);
+	for (std::size_t i = 0; i < ps.size(); ++i) {
+		if (!ps.active[i]) {
+			continue;
+		}
+		auto corner = hud_corner(i, width, height, scale);
+		glUniform2f(image_prog->getUniform("origin"), corner.ammo_x / width, corner.y / height);
+		gl_state::bind_texture(0, choose_tex(ps.ammo_count[i]));
 		render::render_fullscreen_quad();
 	}
 
-	if (players::player_list[3].active) {
-		glUniform2f(image_prog->getUniform("origin"), 10.0f, 10.0f);
-
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, choose_tex(players::player_list[3].ammo_count));
-
-		render::render_fullscreen_quad();
-	}
-
-	glUniform2f(image_prog->getUniform("size"), 100.0f / float(screen_width),
-	            102.0f / float(screen_height));
-
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, bomb_tex);
-
-	if (players::player_list[0].active &&
-	    players::player_list[0].power == players::player_info::powerup::bomb) {
-		glUniform2f(image_prog->getUniform("origin"), 60.0f / float(screen_width),
-		            (float(screen_height) - 110.0f) / float(screen_height));
-
-		render::render_fullscreen_quad();
-	}
-
-	if (players::player_list[1].active &&
-	    players::player_list[1].power == players::player_info::powerup::bomb) {
-		glUniform2f(image_prog->getUniform("origin"),
-		            (float(screen_width) - 160.f) / float(screen_width),
-		            (float(screen_height) - 110.0f) / float(screen_height));
-
-		render::render_fullscreen_quad();
-	}
-
-	if (players::player_list[2].active &&
-	    players::player_list[2].power == players::player_info::powerup::bomb) {
-		glUniform2f(image_prog->getUniform("origin"),
-		            (float(screen_width) - 160.f) / float(screen_width), 0);
-
-		render::render_fullscreen_quad();
-	}
-
-	if (players::player_list[3].active &&
-	    players::player_list[3].power == players::player_info::powerup::bomb) {
-		glUniform2f(image_prog->getUniform("origin"), 60.0f, 10.0f);
-
+	glUniform2f(image_prog->getUniform("size"), 100.0f * scale / width, 102.0f * scale / height);
+	gl_state::bind_texture(0, bomb_tex);
+	for (std::size_t i = 0; i < ps.size(); ++i) {
+		if (!ps.active[i] || ps.power[i] != players::player_info::powerup::bomb) {
+			continue;
+		}
+		auto corner = hud_corner(i, width, height, scale);
+		glUniform2f(image_prog->getUniform("origin"), corner.bomb_x / width, corner.y / height);
 		render::render_fullscreen_quad();
 	}
 
 	glUniform2f(image_prog->getUniform("size"), 547.0f / float(screen_width),
 	            43.0f / float(screen_height));
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, reset_tex);
+	gl_state::bind_texture(0, reset_tex);
 
 	glUniform2f(image_prog->getUniform("origin"),
 	            ((float(screen_width) / 2.0f) - 273.5f) / float(screen_width),
@@ -153,5 +131,5 @@ void ui::render(std::size_t screen_width, std::size_t screen_height) {
 
 	render::render_fullscreen_quad();
 
-	glDisable(GL_BLEND);
+	gl_state::set_enabled(GL_BLEND, false);
 }
\ No newline at end of file
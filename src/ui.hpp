@@ -1,8 +1,9 @@
 #pragma once
 
+#include "core/game.hpp"
 #include <array>
 
 namespace ui {
 	void initialize();
-	void render(std::size_t screen_width, std::size_t screen_height);
+	void render(const game::World& world, std::size_t screen_width, std::size_t screen_height);
 }
\ No newline at end of file